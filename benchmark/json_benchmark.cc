@@ -0,0 +1,193 @@
+// MIT License
+//
+// Copyright (c) 2022 Streamlet (streamlet@outlook.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <xl/json>
+#include <xl/native_string>
+
+//
+// Measures parsing a struct with 64 members from an object with the same 64 keys, in reverse order, with the
+// single-pass XL_JSON reader, against looking each member up by name with yyjson_obj_get in the same yyjson DOM, as
+// XL_JSON did before.
+//
+// Then measures a round trip of a small RPC message, parsed and dumped again, with fresh allocations on every call and
+// with an xl::json::arena and an output string reused across calls.
+//
+// Last, compares the encoded size and the round trip time of both structs as JSON and as MessagePack.
+//
+
+namespace {
+
+const int PARSES = 20000;
+const int ROUND_TRIPS = 200000;
+
+#define WIDE_FIELDS(FIELD)                                                                                             \
+  FIELD(field00) FIELD(field01) FIELD(field02) FIELD(field03) FIELD(field04) FIELD(field05) FIELD(field06)             \
+  FIELD(field07) FIELD(field08) FIELD(field09) FIELD(field10) FIELD(field11) FIELD(field12) FIELD(field13)             \
+  FIELD(field14) FIELD(field15) FIELD(field16) FIELD(field17) FIELD(field18) FIELD(field19) FIELD(field20)             \
+  FIELD(field21) FIELD(field22) FIELD(field23) FIELD(field24) FIELD(field25) FIELD(field26) FIELD(field27)             \
+  FIELD(field28) FIELD(field29) FIELD(field30) FIELD(field31) FIELD(field32) FIELD(field33) FIELD(field34)             \
+  FIELD(field35) FIELD(field36) FIELD(field37) FIELD(field38) FIELD(field39) FIELD(field40) FIELD(field41)             \
+  FIELD(field42) FIELD(field43) FIELD(field44) FIELD(field45) FIELD(field46) FIELD(field47) FIELD(field48)             \
+  FIELD(field49) FIELD(field50) FIELD(field51) FIELD(field52) FIELD(field53) FIELD(field54) FIELD(field55)             \
+  FIELD(field56) FIELD(field57) FIELD(field58) FIELD(field59) FIELD(field60) FIELD(field61) FIELD(field62)             \
+  FIELD(field63)
+
+#define WIDE_MEMBER(name) XL_JSON_MEMBER(long long, name)
+XL_JSON_BEGIN(Wide)
+  WIDE_FIELDS(WIDE_MEMBER)
+XL_JSON_END()
+
+#define WIDE_NAME(name) #name,
+const char *WIDE_NAMES[] = {WIDE_FIELDS(WIDE_NAME)};
+const int WIDE_FIELD_COUNT = sizeof(WIDE_NAMES) / sizeof(WIDE_NAMES[0]);
+
+XL_JSON_BEGIN(Request)
+  XL_JSON_MEMBER(std::string, jsonrpc)
+  XL_JSON_MEMBER(long long, id)
+  XL_JSON_MEMBER(std::string, method)
+  XL_JSON_MEMBER(std::vector<int>, params)
+XL_JSON_END()
+
+const char *REQUEST_JSON = R"({"jsonrpc":"2.0","id":12345,"method":"subtract","params":[42,23,7]})";
+
+long long now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+long long lookup_parse(const std::string &json) {
+  yyjson_doc *doc = yyjson_read(json.data(), json.length(), 0);
+  yyjson_val *root = yyjson_doc_get_root(doc);
+  long long sum = 0;
+  for (int i = 0; i < WIDE_FIELD_COUNT; ++i) {
+    sum += (long long)yyjson_get_num(yyjson_obj_get(root, WIDE_NAMES[i]));
+  }
+  yyjson_doc_free(doc);
+  return sum;
+}
+
+} // namespace
+
+int _tmain(int argc, const TCHAR *argv[]) {
+  std::string json = "{";
+  for (int i = WIDE_FIELD_COUNT - 1; i >= 0; --i) {
+    json += "\"";
+    json += WIDE_NAMES[i];
+    json += "\":";
+    json += std::to_string(i * 1000);
+    json += i > 0 ? "," : "}";
+  }
+
+  long long sum = 0;
+  long long begin = now_ns();
+  for (int i = 0; i < PARSES; ++i) {
+    sum += lookup_parse(json);
+  }
+  long long lookup_ns = now_ns() - begin;
+
+  begin = now_ns();
+  for (int i = 0; i < PARSES; ++i) {
+    Wide wide;
+    wide.json_parse(json.c_str());
+    sum += wide.field63;
+  }
+  long long single_pass_ns = now_ns() - begin;
+
+  begin = now_ns();
+  for (int i = 0; i < ROUND_TRIPS; ++i) {
+    Request request;
+    request.json_parse(REQUEST_JSON);
+    sum += request.json_dump().length();
+  }
+  long long fresh_ns = now_ns() - begin;
+
+  xl::json::arena arena;
+  std::string output;
+  begin = now_ns();
+  for (int i = 0; i < ROUND_TRIPS; ++i) {
+    Request request;
+    request.json_parse(REQUEST_JSON, arena);
+    request.json_dump(output, xl::json::WRITE_FLAG_NONE, arena);
+    sum += output.length();
+  }
+  long long arena_ns = now_ns() - begin;
+
+  Wide wide;
+  wide.json_parse(json.c_str());
+  Request request;
+  request.json_parse(REQUEST_JSON);
+  std::string wide_json = wide.json_dump(), wide_msgpack = wide.msgpack_dump();
+  std::string request_json = request.json_dump(), request_msgpack = request.msgpack_dump();
+
+  begin = now_ns();
+  for (int i = 0; i < PARSES; ++i) {
+    wide.json_parse(wide_json.c_str(), wide_json.length(), arena);
+    wide.json_dump(output, xl::json::WRITE_FLAG_NONE, arena);
+    sum += output.length();
+  }
+  long long wide_json_ns = now_ns() - begin;
+
+  begin = now_ns();
+  for (int i = 0; i < PARSES; ++i) {
+    wide.msgpack_parse(wide_msgpack);
+    wide.msgpack_dump(output);
+    sum += output.length();
+  }
+  long long wide_msgpack_ns = now_ns() - begin;
+
+  begin = now_ns();
+  for (int i = 0; i < ROUND_TRIPS; ++i) {
+    request.json_parse(request_json.c_str(), request_json.length(), arena);
+    request.json_dump(output, xl::json::WRITE_FLAG_NONE, arena);
+    sum += output.length();
+  }
+  long long request_json_ns = now_ns() - begin;
+
+  begin = now_ns();
+  for (int i = 0; i < ROUND_TRIPS; ++i) {
+    request.msgpack_parse(request_msgpack);
+    request.msgpack_dump(output);
+    sum += output.length();
+  }
+  long long request_msgpack_ns = now_ns() - begin;
+
+  _tprintf(_T("%-16s %12s\n"), _T("reader"), _T("ns/parse"));
+  _tprintf(_T("%-16s %12.0f\n"), _T("lookup by name"), (double)lookup_ns / PARSES);
+  _tprintf(_T("%-16s %12.0f\n"), _T("single pass"), (double)single_pass_ns / PARSES);
+  _tprintf(_T("%-16s %12s\n"), _T("round trip"), _T("ns/message"));
+  _tprintf(_T("%-16s %12.0f\n"), _T("fresh"), (double)fresh_ns / ROUND_TRIPS);
+  _tprintf(_T("%-16s %12.0f\n"), _T("arena"), (double)arena_ns / ROUND_TRIPS);
+  _tprintf(_T("%-16s %12s %12s\n"), _T("format"), _T("bytes"), _T("ns/trip"));
+  _tprintf(_T("%-16s %12d %12.0f\n"), _T("wide json"), (int)wide_json.length(), (double)wide_json_ns / PARSES);
+  _tprintf(_T("%-16s %12d %12.0f\n"), _T("wide msgpack"), (int)wide_msgpack.length(), (double)wide_msgpack_ns / PARSES);
+  _tprintf(_T("%-16s %12d %12.0f\n"), _T("request json"), (int)request_json.length(),
+           (double)request_json_ns / ROUND_TRIPS);
+  _tprintf(_T("%-16s %12d %12.0f\n"), _T("request msgpack"), (int)request_msgpack.length(),
+           (double)request_msgpack_ns / ROUND_TRIPS);
+  _tprintf(_T("checksum: %lld\n"), sum);
+  return 0;
+}
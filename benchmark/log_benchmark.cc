@@ -0,0 +1,110 @@
+// MIT License
+//
+// Copyright (c) 2022 Streamlet (streamlet@outlook.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <vector>
+#include <xl/file>
+#include <xl/log>
+#include <xl/log_setup>
+#include <xl/native_string>
+#include <xl/thread>
+
+//
+// Measures XL_LOG_INFO per-call latency on producer threads, and overall throughput, from 1 to 64 producers.
+//
+// Usage: log_benchmark [Block|DropNewest|DropOldest] [Shared|PerThread]
+//
+
+namespace {
+
+const int CALLS_PER_THREAD = 100000;
+const int THREAD_COUNTS[] = {1, 2, 4, 8, 16, 32, 64};
+
+long long now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+void run_round(int thread_count) {
+  std::atomic<bool> start(false);
+  std::atomic<long long> producer_ns(0);
+  std::vector<std::unique_ptr<xl::thread>> threads;
+  for (int i = 0; i < thread_count; ++i) {
+    threads.emplace_back(new xl::thread([&, i]() {
+      while (!start.load()) {
+      }
+      long long begin = now_ns();
+      for (int j = 0; j < CALLS_PER_THREAD; ++j) {
+        XL_LOG_INFO("benchmark thread ", i, " call ", j, " value ", 3.14);
+      }
+      producer_ns.fetch_add(now_ns() - begin);
+    }));
+  }
+  long long begin = now_ns();
+  start.store(true);
+  for (auto &t : threads) {
+    t->join();
+  }
+  long long elapsed = now_ns() - begin;
+  long long calls = (long long)thread_count * CALLS_PER_THREAD;
+  _tprintf(_T("%8d %16.1f %18.0f %14llu\n"), thread_count, (double)producer_ns.load() / calls,
+           calls * 1e9 / elapsed, xl::log::dropped());
+}
+
+} // namespace
+
+int _tmain(int argc, const TCHAR *argv[]) {
+  int overflow = xl::log::LOG_OVERFLOW_BLOCK;
+  if (argc > 1) {
+    xl::native_string policy = argv[1];
+    if (policy == _T("DropNewest")) {
+      overflow = xl::log::LOG_OVERFLOW_DROP_NEWEST;
+    } else if (policy == _T("DropOldest")) {
+      overflow = xl::log::LOG_OVERFLOW_DROP_OLDEST;
+    }
+  }
+  int queue = xl::log::LOG_QUEUE_SHARED;
+  if (argc > 2) {
+    xl::native_string mode = argv[2];
+    if (mode == _T("PerThread")) {
+      queue = xl::log::LOG_QUEUE_PER_THREAD;
+    }
+  }
+
+  const TCHAR *log_file = _T("log_benchmark.log");
+  xl::fs::unlink(log_file);
+  xl::log::setup_queue(queue);
+  xl::log::setup(_T("log_benchmark"), XL_LOG_LEVEL_INFO, xl::log::LOG_CONTENT_DEFAULT, xl::log::LOG_TARGET_FILE,
+                 log_file, overflow);
+
+  _tprintf(_T("%8s %16s %18s %14s\n"), _T("threads"), _T("ns/call"), _T("calls/s"), _T("dropped"));
+  for (int thread_count : THREAD_COUNTS) {
+    run_round(thread_count);
+  }
+
+  xl::log::shutdown();
+  xl::fs::unlink(log_file);
+  return 0;
+}
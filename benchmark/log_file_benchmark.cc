@@ -0,0 +1,98 @@
+// MIT License
+//
+// Copyright (c) 2022 Streamlet (streamlet@outlook.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <chrono>
+#include <cstdio>
+#include <xl/file>
+#include <xl/log>
+#include <xl/log_setup>
+#include <xl/native_string>
+
+//
+// Measures lines per second written to a log file: once with fprintf and fflush per line as a baseline, and once
+// through XL_LOG_INFO, timed until shutdown has written and closed the file.
+//
+// Usage: log_file_benchmark [None|Batch|Sync]
+//
+
+namespace {
+
+const int LINES = 1000000;
+const TCHAR *LOG_FILE = _T("log_file_benchmark.log");
+
+long long now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+void print_row(const TCHAR *name, long long ns) {
+  _tprintf(_T("%-16s %14.0f\n"), name, LINES * 1e9 / ns);
+}
+
+void run_fflush_per_line() {
+  xl::fs::unlink(LOG_FILE);
+  FILE *f = _tfopen(LOG_FILE, _T("ab"));
+  long long begin = now_ns();
+  for (int i = 0; i < LINES; ++i) {
+    fprintf(f, "[INFO][log_file_benchmark]benchmark line %d value %g\n", i, 3.14);
+    fflush(f);
+  }
+  fclose(f);
+  print_row(_T("fflush per line"), now_ns() - begin);
+  xl::fs::unlink(LOG_FILE);
+}
+
+void run_xl(const TCHAR *name, int durability) {
+  xl::fs::unlink(LOG_FILE);
+  xl::log::setup(_T("log_file_benchmark"), XL_LOG_LEVEL_INFO,
+                 xl::log::LOG_CONTENT_LEVEL | xl::log::LOG_CONTENT_APP_NAME, xl::log::LOG_TARGET_FILE, LOG_FILE,
+                 xl::log::LOG_OVERFLOW_BLOCK, durability);
+  long long begin = now_ns();
+  for (int i = 0; i < LINES; ++i) {
+    XL_LOG_INFO("benchmark line ", i, " value ", 3.14);
+  }
+  xl::log::shutdown();
+  print_row(name, now_ns() - begin);
+  xl::fs::unlink(LOG_FILE);
+}
+
+} // namespace
+
+int _tmain(int argc, const TCHAR *argv[]) {
+  const TCHAR *name = _T("Batch");
+  int durability = xl::log::LOG_DURABILITY_BATCH;
+  if (argc > 1) {
+    xl::native_string mode = argv[1];
+    if (mode == _T("None")) {
+      name = _T("None");
+      durability = xl::log::LOG_DURABILITY_NONE;
+    } else if (mode == _T("Sync")) {
+      name = _T("Sync");
+      durability = xl::log::LOG_DURABILITY_SYNC;
+    }
+  }
+
+  _tprintf(_T("%-16s %14s\n"), _T("writer"), _T("lines/s"));
+  run_fflush_per_line();
+  run_xl(name, durability);
+  return 0;
+}
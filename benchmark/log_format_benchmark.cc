@@ -0,0 +1,162 @@
+// MIT License
+//
+// Copyright (c) 2022 Streamlet (streamlet@outlook.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <iomanip>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <xl/file>
+#include <xl/log>
+#include <xl/log_setup>
+#include <xl/native_string>
+
+//
+// Measures heap allocations and nanoseconds per log line, for a reproduction of the previous stringstream-based
+// collect-and-format path ("legacy") and for XL_LOG_INFO. Both write every line to a file. The caller column counts
+// allocations on the logging thread only; the total column and ns/line also include the log thread's rendering.
+//
+
+namespace {
+
+std::atomic<long long> total_allocations(0);
+thread_local long long thread_allocations = 0;
+
+} // namespace
+
+void *operator new(size_t size) {
+  total_allocations.fetch_add(1, std::memory_order_relaxed);
+  ++thread_allocations;
+  void *p = malloc(size == 0 ? 1 : size);
+  if (p == nullptr) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void operator delete(void *p) noexcept {
+  free(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+  free(p);
+}
+
+namespace {
+
+const int CALLS = 200000;
+
+long long now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+template <typename... T>
+void legacy_collect(std::vector<std::string> &messages, T... args);
+
+template <typename T, typename... R>
+void legacy_collect(std::vector<std::string> &messages, T arg, R... rest) {
+  std::stringstream ss;
+  ss << arg;
+  messages.push_back(ss.str());
+  legacy_collect(messages, rest...);
+}
+
+template <>
+void legacy_collect(std::vector<std::string> &messages) {
+}
+
+std::string legacy_format(const std::vector<std::string> &messages) {
+  std::stringstream ss;
+  auto now = std::chrono::time_point_cast<std::chrono::milliseconds>(std::chrono::system_clock::now());
+  time_t now_t = std::chrono::system_clock::to_time_t(now);
+  ss << '[' << std::put_time(std::localtime(&now_t), "%F %T.") << (now.time_since_epoch().count() % 1000) << ']';
+  ss << "[INFO][log_format_benchmark]";
+  for (const auto &message : messages) {
+    ss << message;
+  }
+  ss << std::endl;
+  return ss.str();
+}
+
+const TCHAR *LOG_FILE = _T("log_format_benchmark.log");
+
+void print_row(const TCHAR *name, long long caller_allocations, long long total, long long ns) {
+  _tprintf(_T("%-8s %18.2f %18.2f %10.1f\n"), name, (double)caller_allocations / CALLS, (double)total / CALLS,
+           (double)ns / CALLS);
+}
+
+void run_legacy() {
+  xl::fs::unlink(LOG_FILE);
+  FILE *f = _tfopen(LOG_FILE, _T("ab"));
+  long long caller_allocations = 0;
+  long long total_begin = total_allocations.load();
+  long long begin = now_ns();
+  for (int i = 0; i < CALLS; ++i) {
+    long long allocations_begin = thread_allocations;
+    std::vector<std::string> messages;
+    legacy_collect(messages, "benchmark call ", i, " value ", 3.14, " done");
+    caller_allocations += thread_allocations - allocations_begin;
+    std::string line = legacy_format(messages);
+    fwrite(line.data(), 1, line.length(), f);
+    fflush(f);
+  }
+  long long ns = now_ns() - begin;
+  fclose(f);
+  print_row(_T("legacy"), caller_allocations, total_allocations.load() - total_begin, ns);
+  xl::fs::unlink(LOG_FILE);
+}
+
+void run_xl() {
+  xl::fs::unlink(LOG_FILE);
+  xl::log::setup(_T("log_format_benchmark"), XL_LOG_LEVEL_INFO, xl::log::LOG_CONTENT_TIME | xl::log::LOG_CONTENT_LEVEL |
+                     xl::log::LOG_CONTENT_APP_NAME, xl::log::LOG_TARGET_FILE, LOG_FILE);
+  // Warm up the per-thread scratch buffer and the log thread's render buffers
+  XL_LOG_INFO("benchmark call ", 0, " value ", 3.14, " done");
+
+  long long total_begin = total_allocations.load();
+  long long allocations_begin = thread_allocations;
+  long long begin = now_ns();
+  for (int i = 0; i < CALLS; ++i) {
+    XL_LOG_INFO("benchmark call ", i, " value ", 3.14, " done");
+  }
+  long long caller_allocations = thread_allocations - allocations_begin;
+  xl::log::shutdown();
+  long long ns = now_ns() - begin;
+  print_row(_T("xl"), caller_allocations, total_allocations.load() - total_begin, ns);
+  xl::fs::unlink(LOG_FILE);
+}
+
+} // namespace
+
+int _tmain(int argc, const TCHAR *argv[]) {
+  _tprintf(_T("%-8s %18s %18s %10s\n"), _T("path"), _T("caller allocs/line"), _T("total allocs/line"),
+           _T("ns/line"));
+  run_legacy();
+  run_xl();
+  return 0;
+}
@@ -0,0 +1,86 @@
+// MIT License
+//
+// Copyright (c) 2022 Streamlet (streamlet@outlook.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <xl/log>
+#include <xl/log_setup>
+
+//
+// Measures the cost of an XL_LOG_DEBUG call disabled at run time (level set to Info), against an empty loop. The
+// argument is built by a function that counts its calls, to show it is never evaluated. Also measures an enabled
+// XL_LOG_EVERY_N call that logs once and suppresses every other call, whose argument is evaluated once.
+//
+
+namespace {
+
+const int CALLS = 100000000;
+
+int evaluated = 0;
+volatile int sink = 0;
+
+std::string expensive_argument(int i) {
+  ++evaluated;
+  return std::string(64, (char)('a' + i % 26));
+}
+
+long long now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+} // namespace
+
+int _tmain(int argc, const TCHAR *argv[]) {
+  xl::log::setup(_T("log_level_benchmark"), XL_LOG_LEVEL_INFO, xl::log::LOG_CONTENT_DEFAULT,
+                 xl::log::LOG_TARGET_STDOUT);
+
+  long long begin = now_ns();
+  for (int i = 0; i < CALLS; ++i) {
+    sink = i;
+  }
+  long long empty_ns = now_ns() - begin;
+
+  begin = now_ns();
+  for (int i = 0; i < CALLS; ++i) {
+    sink = i;
+    XL_LOG_DEBUG("value ", expensive_argument(i), " at ", i);
+  }
+  long long disabled_ns = now_ns() - begin;
+
+  begin = now_ns();
+  for (int i = 0; i < CALLS; ++i) {
+    sink = i;
+    XL_LOG_EVERY_N(XL_LOG_LEVEL_WARN, CALLS, "value ", expensive_argument(i), " at ", i);
+  }
+  long long suppressed_ns = now_ns() - begin;
+
+  xl::log::shutdown();
+
+  _tprintf(_T("%-16s %10s\n"), _T("loop"), _T("ns/call"));
+  _tprintf(_T("%-16s %10.3f\n"), _T("empty"), (double)empty_ns / CALLS);
+  _tprintf(_T("%-16s %10.3f\n"), _T("disabled debug"), (double)disabled_ns / CALLS);
+  _tprintf(_T("%-16s %10.3f\n"), _T("suppressed warn"), (double)suppressed_ns / CALLS);
+  _tprintf(_T("arguments evaluated: %d\n"), evaluated);
+  return 0;
+}
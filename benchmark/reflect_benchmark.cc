@@ -0,0 +1,118 @@
+// MIT License
+//
+// Copyright (c) 2022 Streamlet (streamlet@outlook.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <xl/native_string>
+#include <xl/reflect>
+
+//
+// Measures XL_REFLECT field_index on structs with 5, 50 and 500 fields, looking up every field name once per round,
+// against comparing the name with each field in turn with strcmp, as field_index did before. Then measures
+// field_data by runtime index, which reads the struct's field descriptors.
+//
+
+namespace {
+
+const int LOOKUPS = 2000000;
+
+#define FIELDS_5(FIELD, prefix) FIELD(prefix##0) FIELD(prefix##1) FIELD(prefix##2) FIELD(prefix##3) FIELD(prefix##4)
+#define FIELDS_10(FIELD, prefix) FIELDS_5(FIELD, prefix##0) FIELDS_5(FIELD, prefix##1)
+#define FIELDS_50(FIELD, prefix)                                                                                       \
+  FIELDS_10(FIELD, prefix##0) FIELDS_10(FIELD, prefix##1) FIELDS_10(FIELD, prefix##2) FIELDS_10(FIELD, prefix##3)      \
+  FIELDS_10(FIELD, prefix##4)
+#define FIELDS_500(FIELD, prefix)                                                                                      \
+  FIELDS_50(FIELD, prefix##0) FIELDS_50(FIELD, prefix##1) FIELDS_50(FIELD, prefix##2) FIELDS_50(FIELD, prefix##3)      \
+  FIELDS_50(FIELD, prefix##4) FIELDS_50(FIELD, prefix##5) FIELDS_50(FIELD, prefix##6) FIELDS_50(FIELD, prefix##7)      \
+  FIELDS_50(FIELD, prefix##8) FIELDS_50(FIELD, prefix##9)
+
+#define MEMBER(name) XL_REFLECT_MEMBER(int, name)
+#define NAME(name) #name,
+
+XL_REFLECT_BEGIN(Fields5)
+  FIELDS_5(MEMBER, field)
+XL_REFLECT_END()
+
+XL_REFLECT_BEGIN(Fields50)
+  FIELDS_50(MEMBER, field)
+XL_REFLECT_END()
+
+XL_REFLECT_BEGIN(Fields500)
+  FIELDS_500(MEMBER, field)
+XL_REFLECT_END()
+
+const char *NAMES_5[] = {FIELDS_5(NAME, field)};
+const char *NAMES_50[] = {FIELDS_50(NAME, field)};
+const char *NAMES_500[] = {FIELDS_500(NAME, field)};
+
+long long now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+size_t linear_index(const char **names, size_t count, const char *name) {
+  for (size_t i = 0; i < count; ++i) {
+    if (strcmp(names[i], name) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+template <typename Struct, size_t Count>
+void measure(const TCHAR *title, const char *(&names)[Count]) {
+  size_t sum = 0;
+  long long begin = now_ns();
+  for (int i = 0; i < LOOKUPS; ++i) {
+    sum += linear_index(names, Count, names[i % Count]);
+  }
+  long long linear_ns = now_ns() - begin;
+
+  begin = now_ns();
+  for (int i = 0; i < LOOKUPS; ++i) {
+    sum += Struct::field_index(names[i % Count]);
+  }
+  long long index_ns = now_ns() - begin;
+
+  Struct value;
+  begin = now_ns();
+  for (int i = 0; i < LOOKUPS; ++i) {
+    sum += (size_t)value.field_data(i % Count);
+  }
+  long long data_ns = now_ns() - begin;
+
+  _tprintf(_T("%-16s %12.1f %12.1f %12.1f %12d\n"), title, (double)linear_ns / LOOKUPS, (double)index_ns / LOOKUPS,
+           (double)data_ns / LOOKUPS, (int)(sum % 10));
+}
+
+} // namespace
+
+int _tmain(int argc, const TCHAR *argv[]) {
+  _tprintf(_T("%-16s %12s %12s %12s %12s\n"), _T("fields"), _T("strcmp ns"), _T("index ns"), _T("data ns"),
+           _T("checksum"));
+  measure<Fields5>(_T("5"), NAMES_5);
+  measure<Fields50>(_T("50"), NAMES_50);
+  measure<Fields500>(_T("500"), NAMES_500);
+  return 0;
+}
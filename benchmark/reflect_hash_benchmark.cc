@@ -0,0 +1,188 @@
+// MIT License
+//
+// Copyright (c) 2022 Streamlet (streamlet@outlook.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <xl/native_string>
+#include <xl/reflect>
+
+//
+// Measures the hash and == generated by XL_REFLECT_END_COMPARABLE against hand-written ones combining std::hash of
+// each field, boost style: hashing alone, then inserting, finding and missing keys in a std::unordered_map. IdKey is
+// all integers, hashed as one block of memory; NameKey adds a string.
+//
+
+namespace {
+
+const int KEYS = 1000000;
+
+XL_REFLECT_BEGIN(IdKey)
+  XL_REFLECT_MEMBER(int, tenant)
+  XL_REFLECT_MEMBER(int, shard)
+  XL_REFLECT_MEMBER(long long, user)
+  XL_REFLECT_MEMBER(short, kind)
+  XL_REFLECT_MEMBER(short, flags)
+  XL_REFLECT_MEMBER(int, region)
+XL_REFLECT_END_COMPARABLE()
+
+XL_REFLECT_BEGIN(NameKey)
+  XL_REFLECT_MEMBER(int, tenant)
+  XL_REFLECT_MEMBER(long long, user)
+  XL_REFLECT_MEMBER(std::string, name)
+XL_REFLECT_END_COMPARABLE()
+
+struct HandIdKey {
+  int tenant;
+  int shard;
+  long long user;
+  short kind;
+  short flags;
+  int region;
+
+  bool operator==(const HandIdKey &that) const {
+    return tenant == that.tenant && shard == that.shard && user == that.user && kind == that.kind &&
+           flags == that.flags && region == that.region;
+  }
+};
+
+struct HandNameKey {
+  int tenant;
+  long long user;
+  std::string name;
+
+  bool operator==(const HandNameKey &that) const {
+    return tenant == that.tenant && user == that.user && name == that.name;
+  }
+};
+
+template <typename T>
+void hash_combine(size_t &seed, const T &value) {
+  seed ^= std::hash<T>()(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+
+struct HandIdKeyHash {
+  size_t operator()(const HandIdKey &key) const {
+    size_t seed = 0;
+    hash_combine(seed, key.tenant);
+    hash_combine(seed, key.shard);
+    hash_combine(seed, key.user);
+    hash_combine(seed, key.kind);
+    hash_combine(seed, key.flags);
+    hash_combine(seed, key.region);
+    return seed;
+  }
+};
+
+struct HandNameKeyHash {
+  size_t operator()(const HandNameKey &key) const {
+    size_t seed = 0;
+    hash_combine(seed, key.tenant);
+    hash_combine(seed, key.user);
+    hash_combine(seed, key.name);
+    return seed;
+  }
+};
+
+long long now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// Keys i and KEYS + i, the latter being missing from the maps
+template <typename Key>
+void fill_id_key(Key &key, int i) {
+  key.tenant = i % 7;
+  key.shard = i % 64;
+  key.user = i * 2654435761LL;
+  key.kind = (short)(i % 3);
+  key.flags = 0;
+  key.region = i / 1000;
+}
+
+template <typename Key>
+void fill_name_key(Key &key, int i) {
+  key.tenant = i % 7;
+  key.user = i / 8;
+  key.name = "user" + std::to_string(i);
+}
+
+template <typename Key>
+std::vector<Key> make_keys(void (*fill)(Key &, int), int begin) {
+  std::vector<Key> keys(KEYS);
+  for (int i = 0; i < KEYS; ++i) {
+    fill(keys[i], begin + i);
+  }
+  return keys;
+}
+
+template <typename Key, typename Hash>
+void measure(const TCHAR *title, void (*fill)(Key &, int)) {
+  std::vector<Key> keys = make_keys(fill, 0);
+  std::vector<Key> missing = make_keys(fill, KEYS);
+  Hash hash;
+
+  size_t sum = 0;
+  long long begin = now_ns();
+  for (const Key &key : keys) {
+    sum += hash(key);
+  }
+  long long hash_ns = now_ns() - begin;
+
+  std::unordered_map<Key, int, Hash> map;
+  begin = now_ns();
+  for (int i = 0; i < KEYS; ++i) {
+    map.emplace(keys[i], i);
+  }
+  long long insert_ns = now_ns() - begin;
+
+  begin = now_ns();
+  for (const Key &key : keys) {
+    sum += map.find(key)->second;
+  }
+  long long find_ns = now_ns() - begin;
+
+  begin = now_ns();
+  for (const Key &key : missing) {
+    sum += map.count(key);
+  }
+  long long miss_ns = now_ns() - begin;
+
+  _tprintf(_T("%-16s %10.1f %10.1f %10.1f %10.1f %10d\n"), title, (double)hash_ns / KEYS, (double)insert_ns / KEYS,
+           (double)find_ns / KEYS, (double)miss_ns / KEYS, (int)(sum % 10));
+}
+
+} // namespace
+
+int _tmain(int argc, const TCHAR *argv[]) {
+  _tprintf(_T("%-16s %10s %10s %10s %10s %10s\n"), _T("key"), _T("hash ns"), _T("insert ns"), _T("find ns"),
+           _T("miss ns"), _T("checksum"));
+  measure<HandIdKey, HandIdKeyHash>(_T("id hand"), fill_id_key<HandIdKey>);
+  measure<IdKey, xl::reflect_hash>(_T("id reflect"), fill_id_key<IdKey>);
+  measure<HandNameKey, HandNameKeyHash>(_T("name hand"), fill_name_key<HandNameKey>);
+  measure<NameKey, xl::reflect_hash>(_T("name reflect"), fill_name_key<NameKey>);
+  return 0;
+}
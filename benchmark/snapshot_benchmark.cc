@@ -0,0 +1,144 @@
+// MIT License
+//
+// Copyright (c) 2022 Streamlet (streamlet@outlook.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <xl/file>
+#include <xl/json_lines>
+#include <xl/native_string>
+#include <xl/snapshot>
+
+//
+// Measures persisting and loading 1M records as JSON lines and as a snapshot: writing the file, loading every row,
+// and opening the snapshot to sum one field in place in the mapping.
+//
+
+namespace {
+
+const int ROWS = 1000000;
+
+XL_JSON_BEGIN(JsonRecord)
+  XL_JSON_MEMBER(int, id)
+  XL_JSON_MEMBER(double, price)
+  XL_JSON_MEMBER(int, quantity)
+  XL_JSON_MEMBER(std::string, name)
+  XL_JSON_MEMBER(std::vector<int>, tags)
+XL_JSON_END()
+
+XL_REFLECT_BEGIN(Record)
+  XL_REFLECT_MEMBER(int, id)
+  XL_REFLECT_MEMBER(double, price)
+  XL_REFLECT_MEMBER(int, quantity)
+  XL_REFLECT_MEMBER(std::string, name)
+  XL_REFLECT_MEMBER(std::vector<int>, tags)
+XL_REFLECT_END()
+
+long long now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+template <typename T>
+std::vector<T> make_records() {
+  std::vector<T> records(ROWS);
+  for (int i = 0; i < ROWS; ++i) {
+    T &record = records[i];
+    record.id = i;
+    record.price = i * 0.25;
+    record.quantity = i % 100;
+    record.name = "record" + std::to_string(i);
+    record.tags.assign(i % 4, i);
+  }
+  return records;
+}
+
+void print(const TCHAR *title, long long ns, const TCHAR *path, double checksum) {
+  _tprintf(_T("%-24s %12.1f %12.1f %16.0f\n"), title, (double)ns / 1000000, (double)xl::fs::size(path) / 1024 / 1024,
+           checksum);
+}
+
+void measure_json_lines(const TCHAR *path) {
+  std::vector<JsonRecord> records = make_records<JsonRecord>();
+  long long begin = now_ns();
+  FILE *f = _tfopen(path, _T("wb"));
+  if (f == nullptr) {
+    return;
+  }
+  xl::json::write_lines(records, [f](const void *buffer, size_t size) {
+    return fwrite(buffer, 1, size, f);
+  });
+  fclose(f);
+  print(_T("json lines write"), now_ns() - begin, path, 0);
+
+  double sum = 0;
+  begin = now_ns();
+  std::vector<JsonRecord> loaded;
+  loaded.reserve(ROWS);
+  xl::json::read_lines_file<JsonRecord>(path, [&loaded](JsonRecord &record) {
+    loaded.push_back(std::move(record));
+    return true;
+  });
+  for (const JsonRecord &record : loaded) {
+    sum += record.price;
+  }
+  print(_T("json lines load"), now_ns() - begin, path, sum);
+  xl::fs::unlink(path);
+}
+
+void measure_snapshot(const TCHAR *path) {
+  std::vector<Record> records = make_records<Record>();
+  long long begin = now_ns();
+  xl::snapshot::save(path, records);
+  print(_T("snapshot write"), now_ns() - begin, path, 0);
+
+  double sum = 0;
+  begin = now_ns();
+  std::vector<Record> loaded;
+  xl::snapshot::load(path, loaded);
+  for (const Record &record : loaded) {
+    sum += record.price;
+  }
+  print(_T("snapshot load"), now_ns() - begin, path, sum);
+
+  sum = 0;
+  begin = now_ns();
+  xl::snapshot::reader<Record> reader;
+  reader.open(path);
+  for (size_t i = 0; i < reader.size(); ++i) {
+    sum += *reader.data<1>(i);
+  }
+  reader.close();
+  print(_T("snapshot in place"), now_ns() - begin, path, sum);
+  xl::fs::unlink(path);
+}
+
+} // namespace
+
+int _tmain(int argc, const TCHAR *argv[]) {
+  _tprintf(_T("%-24s %12s %12s %16s\n"), _T("operation"), _T("ms"), _T("file MB"), _T("checksum"));
+  measure_json_lines(_T("snapshot_benchmark.jsonl"));
+  measure_snapshot(_T("snapshot_benchmark.bin"));
+  return 0;
+}
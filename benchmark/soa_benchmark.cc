@@ -0,0 +1,163 @@
+// MIT License
+//
+// Copyright (c) 2022 Streamlet (streamlet@outlook.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+#include <xl/native_string>
+#include <xl/soa_vector>
+
+//
+// Measures a field scan, a filter on two fields and a sort by one field over the same records stored as a
+// std::vector of structs and as an xl::soa_vector, which keeps each field in its own column.
+//
+
+namespace {
+
+const int ROWS = 1000000;
+const int ROUNDS = 20;
+
+XL_REFLECT_BEGIN(Record)
+  XL_REFLECT_MEMBER(int, id)
+  XL_REFLECT_MEMBER(double, price)
+  XL_REFLECT_MEMBER(int, quantity)
+  XL_REFLECT_MEMBER(int, category)
+  XL_REFLECT_MEMBER(double, payload0)
+  XL_REFLECT_MEMBER(double, payload1)
+  XL_REFLECT_MEMBER(double, payload2)
+  XL_REFLECT_MEMBER(double, payload3)
+XL_REFLECT_END()
+
+long long now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+std::vector<Record> make_records() {
+  std::vector<Record> records(ROWS);
+  unsigned int seed = 1;
+  for (int i = 0; i < ROWS; ++i) {
+    seed = seed * 1103515245 + 12345;
+    Record &record = records[i];
+    record.id = i;
+    record.price = (seed >> 8) % 100000 / 100.0;
+    record.quantity = (int)(seed % 100);
+    record.category = (int)((seed >> 4) % 16);
+    record.payload0 = record.payload1 = record.payload2 = record.payload3 = i;
+  }
+  return records;
+}
+
+void print(const TCHAR *title, long long aos_ns, long long soa_ns, double checksum) {
+  _tprintf(_T("%-16s %12.2f %12.2f %12.0f\n"), title, (double)aos_ns / 1000000, (double)soa_ns / 1000000, checksum);
+}
+
+void measure_scan(const std::vector<Record> &aos, const xl::soa_vector<Record> &soa) {
+  double sum = 0;
+  long long begin = now_ns();
+  for (int round = 0; round < ROUNDS; ++round) {
+    for (const Record &record : aos) {
+      sum += record.price;
+    }
+  }
+  long long aos_ns = (now_ns() - begin) / ROUNDS;
+
+  begin = now_ns();
+  for (int round = 0; round < ROUNDS; ++round) {
+    for (double price : soa.column<1>()) {
+      sum += price;
+    }
+  }
+  long long soa_ns = (now_ns() - begin) / ROUNDS;
+  print(_T("scan"), aos_ns, soa_ns, sum);
+}
+
+void measure_filter(const std::vector<Record> &aos, const xl::soa_vector<Record> &soa) {
+  std::vector<int> ids;
+  ids.reserve(ROWS);
+  double count = 0;
+  long long begin = now_ns();
+  for (int round = 0; round < ROUNDS; ++round) {
+    ids.clear();
+    for (const Record &record : aos) {
+      if (record.category == 3 && record.price < 500) {
+        ids.push_back(record.id);
+      }
+    }
+    count += ids.size();
+  }
+  long long aos_ns = (now_ns() - begin) / ROUNDS;
+
+  begin = now_ns();
+  for (int round = 0; round < ROUNDS; ++round) {
+    ids.clear();
+    xl::soa_span<const int> id = soa.column<0>();
+    xl::soa_span<const double> price = soa.column<1>();
+    xl::soa_span<const int> category = soa.column<3>();
+    for (size_t i = 0; i < id.size(); ++i) {
+      if (category[i] == 3 && price[i] < 500) {
+        ids.push_back(id[i]);
+      }
+    }
+    count += ids.size();
+  }
+  long long soa_ns = (now_ns() - begin) / ROUNDS;
+  print(_T("filter"), aos_ns, soa_ns, count);
+}
+
+void measure_sort(const std::vector<Record> &records) {
+  std::vector<Record> aos = records;
+  long long begin = now_ns();
+  std::sort(aos.begin(), aos.end(), [](const Record &lhs, const Record &rhs) {
+    return lhs.price < rhs.price;
+  });
+  long long aos_ns = now_ns() - begin;
+
+  xl::soa_vector<Record> soa;
+  soa.reserve(records.size());
+  for (const Record &record : records) {
+    soa.push_back(record);
+  }
+  begin = now_ns();
+  soa.sort_by<1>();
+  long long soa_ns = now_ns() - begin;
+  print(_T("sort"), aos_ns, soa_ns, aos.front().id + soa[0].get<0>());
+}
+
+} // namespace
+
+int _tmain(int argc, const TCHAR *argv[]) {
+  std::vector<Record> aos = make_records();
+  xl::soa_vector<Record> soa;
+  soa.reserve(aos.size());
+  for (const Record &record : aos) {
+    soa.push_back(record);
+  }
+
+  _tprintf(_T("%-16s %12s %12s %12s\n"), _T("operation"), _T("aos ms"), _T("soa ms"), _T("checksum"));
+  measure_scan(aos, soa);
+  measure_filter(aos, soa);
+  measure_sort(aos);
+  return 0;
+}
@@ -0,0 +1,217 @@
+// MIT License
+//
+// Copyright (c) 2022 Streamlet (streamlet@outlook.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <vector>
+#include <xl/native_string>
+#include <xl/synchronous>
+#include <xl/thread>
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+//
+// Measures uncontended lock/unlock latency, and throughput with 2 to 64 threads contending on one lock.
+// Then measures a read-heavy cache (one write per READS_PER_WRITE reads) guarded by rw_locker or locker.
+//
+// "legacy" is the former POSIX locker, an auto-reset event made of a pthread mutex, a condition variable and a bool.
+//
+
+namespace {
+
+const int UNCONTENDED_LOOPS = 10000000;
+const int CONTENDED_LOOPS = 2000000;
+const int THREAD_COUNTS[] = {2, 4, 8, 16, 32, 64};
+const int READ_HEAVY_THREAD_COUNTS[] = {1, 2, 4, 8, 16, 32, 64};
+const int READ_HEAVY_OPERATIONS = 2000000;
+const int READS_PER_WRITE = 1000;
+const int CACHE_SIZE = 1000;
+
+#ifndef _WIN32
+
+class legacy_locker {
+public:
+  legacy_locker() {
+    pthread_mutex_init(&mutex_, nullptr);
+    pthread_cond_init(&cond_, nullptr);
+  }
+  ~legacy_locker() {
+    pthread_cond_destroy(&cond_);
+    pthread_mutex_destroy(&mutex_);
+  }
+
+  void lock() {
+    pthread_mutex_lock(&mutex_);
+    while (!signaled_) {
+      pthread_cond_wait(&cond_, &mutex_);
+    }
+    signaled_ = false;
+    pthread_mutex_unlock(&mutex_);
+  }
+
+  void unlock() {
+    pthread_mutex_lock(&mutex_);
+    signaled_ = true;
+    pthread_cond_broadcast(&cond_);
+    pthread_mutex_unlock(&mutex_);
+  }
+
+private:
+  pthread_mutex_t mutex_;
+  pthread_cond_t cond_;
+  bool signaled_ = true;
+};
+
+#endif
+
+double now_ns() {
+  return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+template <typename Locker>
+double uncontended_ns() {
+  Locker locker;
+  double begin = now_ns();
+  for (int i = 0; i < UNCONTENDED_LOOPS; ++i) {
+    locker.lock();
+    locker.unlock();
+  }
+  return (now_ns() - begin) / UNCONTENDED_LOOPS;
+}
+
+// Returns lock/unlock pairs per microsecond
+template <typename Locker>
+double contended_throughput(int thread_count) {
+  Locker locker;
+  long long counter = 0;
+  std::atomic<bool> start(false);
+  int loops = CONTENDED_LOOPS / thread_count;
+  std::vector<std::unique_ptr<xl::thread>> threads;
+  for (int i = 0; i < thread_count; ++i) {
+    threads.emplace_back(new xl::thread([&]() {
+      while (!start.load()) {
+      }
+      for (int j = 0; j < loops; ++j) {
+        locker.lock();
+        ++counter;
+        locker.unlock();
+      }
+    }));
+  }
+  double begin = now_ns();
+  start.store(true);
+  for (auto &t : threads) {
+    t->join();
+  }
+  return counter * 1000.0 / (now_ns() - begin);
+}
+
+template <typename Locker>
+void run(const TCHAR *name) {
+  _tprintf(_T("%-10s %12.1f"), name, uncontended_ns<Locker>());
+  for (int thread_count : THREAD_COUNTS) {
+    _tprintf(_T(" %8.2f"), contended_throughput<Locker>(thread_count));
+  }
+  _tprintf(_T("\n"));
+}
+
+struct shared_guard {
+  shared_guard(xl::rw_locker &locker) : guard(locker) {
+  }
+  xl::shared_lock_guard guard;
+};
+
+// Returns operations per microsecond. ReadGuard is the guard type readers take on Locker.
+template <typename Locker, typename ReadGuard>
+double read_heavy_throughput(int thread_count) {
+  Locker locker;
+  std::map<int, int> cache;
+  for (int i = 0; i < CACHE_SIZE; ++i) {
+    cache[i] = i;
+  }
+  std::atomic<bool> start(false);
+  std::atomic<long long> sum(0);
+  int operations = READ_HEAVY_OPERATIONS / thread_count;
+  std::vector<std::unique_ptr<xl::thread>> threads;
+  for (int i = 0; i < thread_count; ++i) {
+    threads.emplace_back(new xl::thread([&, i]() {
+      while (!start.load()) {
+      }
+      long long local_sum = 0;
+      for (int j = 0; j < operations; ++j) {
+        int key = (i * 7919 + j) % CACHE_SIZE;
+        if (j % READS_PER_WRITE == 0) {
+          xl::lock_guard lock(locker);
+          cache[key] = j;
+        } else {
+          ReadGuard lock(locker);
+          local_sum += cache.find(key)->second;
+        }
+      }
+      sum.fetch_add(local_sum);
+    }));
+  }
+  double begin = now_ns();
+  start.store(true);
+  for (auto &t : threads) {
+    t->join();
+  }
+  return (double)operations * thread_count * 1000.0 / (now_ns() - begin);
+}
+
+template <typename Locker, typename ReadGuard>
+void run_read_heavy(const TCHAR *name) {
+  _tprintf(_T("%-10s"), name);
+  for (int thread_count : READ_HEAVY_THREAD_COUNTS) {
+    _tprintf(_T(" %8.2f"), read_heavy_throughput<Locker, ReadGuard>(thread_count));
+  }
+  _tprintf(_T("\n"));
+}
+
+} // namespace
+
+int _tmain(int argc, const TCHAR *argv[]) {
+  _tprintf(_T("%-10s %12s"), _T("locker"), _T("uncontended"));
+  for (int thread_count : THREAD_COUNTS) {
+    _tprintf(_T(" %5d thr"), thread_count);
+  }
+  _tprintf(_T("\n%-10s %12s %s\n"), _T(""), _T("(ns/pair)"), _T("(lock/unlock pairs per us)"));
+  run<xl::locker>(_T("xl"));
+#ifndef _WIN32
+  run<legacy_locker>(_T("legacy"));
+#endif
+
+  _tprintf(_T("\n%-10s"), _T("cache"));
+  for (int thread_count : READ_HEAVY_THREAD_COUNTS) {
+    _tprintf(_T(" %5d thr"), thread_count);
+  }
+  _tprintf(_T("\n%-10s %s\n"), _T(""), _T("(operations per us)"));
+  run_read_heavy<xl::rw_locker, shared_guard>(_T("rw_locker"));
+  run_read_heavy<xl::locker, xl::lock_guard>(_T("locker"));
+  return 0;
+}
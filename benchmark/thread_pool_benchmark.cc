@@ -0,0 +1,133 @@
+// MIT License
+//
+// Copyright (c) 2022 Streamlet (streamlet@outlook.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <vector>
+#include <xl/native_string>
+#include <xl/synchronous>
+#include <xl/task_thread>
+#include <xl/thread_pool>
+
+//
+// Compares xl::thread_pool against N independent xl::task_thread on fine-grained and coarse-grained workloads.
+//
+// Usage: thread_pool_benchmark [threads]
+//
+
+namespace {
+
+const int FINE_TASKS = 200000;
+const int FINE_WORK = 100;
+const int COARSE_TASKS = 200;
+const int COARSE_WORK = 1000000;
+
+volatile unsigned long long sink = 0;
+
+void work(int iterations) {
+  unsigned long long x = 88172645463325252ULL;
+  for (int i = 0; i < iterations; ++i) {
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+  }
+  sink = sink + x;
+}
+
+double now_ms() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch())
+             .count() /
+         1000.0;
+}
+
+double run_task_threads(size_t thread_count, int tasks, int iterations) {
+  std::vector<std::unique_ptr<xl::task_thread>> threads;
+  for (size_t i = 0; i < thread_count; ++i) {
+    threads.emplace_back(new xl::task_thread);
+  }
+  std::atomic<int> remaining(tasks);
+  xl::event done(false, false);
+  double begin = now_ms();
+  for (int i = 0; i < tasks; ++i) {
+    threads[i % thread_count]->post_task([&, iterations]() {
+      work(iterations);
+      if (remaining.fetch_sub(1) == 1) {
+        done.set();
+      }
+    });
+  }
+  done.wait();
+  return now_ms() - begin;
+}
+
+double run_thread_pool(size_t thread_count, int tasks, int iterations) {
+  xl::thread_pool pool(thread_count);
+  std::atomic<int> remaining(tasks);
+  xl::event done(false, false);
+  double begin = now_ms();
+  for (int i = 0; i < tasks; ++i) {
+    pool.post([&, iterations]() {
+      work(iterations);
+      if (remaining.fetch_sub(1) == 1) {
+        done.set();
+      }
+    });
+  }
+  done.wait();
+  return now_ms() - begin;
+}
+
+double run_parallel_for(size_t thread_count, int tasks, int iterations) {
+  xl::thread_pool pool(thread_count);
+  double begin = now_ms();
+  pool.parallel_for(0, tasks, [iterations](int) {
+    work(iterations);
+  });
+  return now_ms() - begin;
+}
+
+} // namespace
+
+int _tmain(int argc, const TCHAR *argv[]) {
+  size_t thread_count = 0;
+  if (argc > 1) {
+    thread_count = (size_t)_ttoi(argv[1]);
+  }
+  if (thread_count == 0) {
+    thread_count = xl::thread_pool().size();
+  }
+
+  _tprintf(_T("threads: %u\n"), (unsigned int)thread_count);
+  _tprintf(_T("%-28s %14s %14s\n"), _T("workload"), _T("task_thread"), _T("thread_pool"));
+  _tprintf(_T("%-28s %11.1f ms %11.1f ms\n"), _T("fine (post)"), run_task_threads(thread_count, FINE_TASKS, FINE_WORK),
+           run_thread_pool(thread_count, FINE_TASKS, FINE_WORK));
+  _tprintf(_T("%-28s %14s %11.1f ms\n"), _T("fine (parallel_for)"), _T("-"),
+           run_parallel_for(thread_count, FINE_TASKS, FINE_WORK));
+  _tprintf(_T("%-28s %11.1f ms %11.1f ms\n"), _T("coarse (post)"),
+           run_task_threads(thread_count, COARSE_TASKS, COARSE_WORK),
+           run_thread_pool(thread_count, COARSE_TASKS, COARSE_WORK));
+  _tprintf(_T("%-28s %14s %11.1f ms\n"), _T("coarse (parallel_for)"), _T("-"),
+           run_parallel_for(thread_count, COARSE_TASKS, COARSE_WORK));
+  return 0;
+}
@@ -0,0 +1,156 @@
+// MIT License
+//
+// Copyright (c) 2022 Streamlet (streamlet@outlook.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <gtest/gtest.h>
+#include <xl/json_lines>
+
+namespace {
+
+XL_JSON_BEGIN(Row)
+  XL_JSON_MEMBER(int, id)
+  XL_JSON_MEMBER(std::string, name)
+  XL_JSON_MEMBER(std::vector<int>, tags)
+XL_JSON_END()
+
+std::vector<Row> make_rows(int count) {
+  std::vector<Row> rows(count);
+  for (int i = 0; i < count; ++i) {
+    rows[i].id = i;
+    rows[i].name = "row" + std::to_string(i);
+  }
+  return rows;
+}
+
+std::string write_rows(const std::vector<Row> &rows) {
+  std::string lines;
+  bool r = xl::json::write_lines(rows, [&lines](const void *buffer, size_t size) {
+    lines.append((const char *)buffer, size);
+    return size;
+  });
+  return r ? lines : "";
+}
+
+// Hands out the data a few bytes at a time
+xl::json::data_reader piecewise_reader(const std::string &data, size_t piece) {
+  size_t offset = 0;
+  return [data, piece, offset](void *buffer, size_t size, long long *total_size) mutable {
+    size_t read = std::min(std::min(size, piece), data.size() - offset);
+    memcpy(buffer, data.data() + offset, read);
+    offset += read;
+    return read;
+  };
+}
+
+} // namespace
+
+TEST(json_lines_test, write_lines) {
+  std::vector<Row> rows = make_rows(2);
+  ASSERT_EQ(write_rows(rows),
+            "{\"id\":0,\"name\":\"row0\",\"tags\":[]}\n{\"id\":1,\"name\":\"row1\",\"tags\":[]}\n");
+  ASSERT_EQ(xl::json::write_lines(rows,
+                                  [](const void *buffer, size_t size) {
+                                    return (size_t)0;
+                                  }),
+            false);
+}
+
+TEST(json_lines_test, read_lines) {
+  std::string lines = "{\"id\":0,\"name\":\"row0\",\"tags\":[1,2]}\r\n\r\n  \n{\"id\":1,\"tags\":[]}\n"
+                      "{\"id\":2,\"name\":\"row2\",\"tags\":[3]}";
+  std::vector<Row> rows;
+  auto collect = [&rows](Row &row) {
+    rows.push_back(row);
+    return true;
+  };
+  ASSERT_EQ(xl::json::read_lines<Row>(lines.data(), lines.size(), collect), true);
+  ASSERT_EQ(rows.size(), 3u);
+  ASSERT_EQ(rows[0].name, "row0");
+  ASSERT_EQ(rows[1].id, 1);
+  ASSERT_EQ(rows[1].name, "");
+  ASSERT_EQ(rows[1].tags.empty(), true);
+  ASSERT_EQ(rows[2].name, "row2");
+  ASSERT_EQ(rows[2].tags, std::vector<int>{3});
+
+  rows.clear();
+  lines = "{\"id\":0}\n{\"id\":\n{\"id\":2}\n";
+  ASSERT_EQ(xl::json::read_lines<Row>(lines.data(), lines.size(), collect), false);
+  ASSERT_EQ(rows.size(), 1u);
+
+  int count = 0;
+  lines = write_rows(make_rows(10));
+  ASSERT_EQ(xl::json::read_lines<Row>(lines.data(), lines.size(),
+                                      [&count](Row &row) {
+                                        return ++count < 3;
+                                      }),
+            false);
+  ASSERT_EQ(count, 3);
+}
+
+TEST(json_lines_test, read_lines_reader) {
+  std::vector<Row> rows = make_rows(100);
+  std::string lines = write_rows(rows);
+  int id = 0;
+  auto check = [&id](Row &row) {
+    return row.id == id && row.name == "row" + std::to_string(id++);
+  };
+  ASSERT_EQ(xl::json::read_lines<Row>(piecewise_reader(lines, 7), check, 16), true);
+  ASSERT_EQ(id, 100);
+
+  lines.pop_back();
+  id = 0;
+  ASSERT_EQ(xl::json::read_lines<Row>(piecewise_reader(lines, 1000), check, 64), true);
+  ASSERT_EQ(id, 100);
+}
+
+TEST(json_lines_test, read_lines_parallel) {
+  xl::thread_pool pool(4);
+  std::vector<Row> rows = make_rows(10000);
+  std::string lines = write_rows(rows);
+  int id = 0;
+  auto check = [&id](Row &row) {
+    return row.id == id && row.name == "row" + std::to_string(id++);
+  };
+  ASSERT_EQ(xl::json::read_lines<Row>(lines.data(), lines.size(), check, pool), true);
+  ASSERT_EQ(id, 10000);
+
+  id = 0;
+  ASSERT_EQ(xl::json::read_lines<Row>(piecewise_reader(lines, 4096), check, pool, 1000), true);
+  ASSERT_EQ(id, 10000);
+
+  id = 0;
+  lines.insert(lines.find("{\"id\":5000,"), "{\n");
+  ASSERT_EQ(xl::json::read_lines<Row>(piecewise_reader(lines, 4096), check, pool, 1000), false);
+  ASSERT_EQ(id, 5000);
+}
+
+TEST(json_lines_test, read_lines_file) {
+  const TCHAR *path = _T("json_lines_test.jsonl");
+  ASSERT_EQ(xl::file::write(path, write_rows(make_rows(100))), true);
+  int id = 0;
+  ASSERT_EQ(xl::json::read_lines_file<Row>(path,
+                                           [&id](Row &row) {
+                                             return row.id == id++;
+                                           }),
+            true);
+  ASSERT_EQ(id, 100);
+  xl::fs::unlink(path);
+}
@@ -133,6 +133,28 @@ TEST(json_test, single_values_string_view) {
   ASSERT_EQ(json.json_dump(), remove_blanks(SILNGLE_VALUES_JSON));
 }
 
+TEST(json_test, string_view_document) {
+  std::string json_string = SILNGLE_VALUES_JSON;
+  SingleValuesStringView json;
+  xl::json::document document;
+  ASSERT_EQ(json.json_parse(json_string.c_str(), document), true);
+  json_string.assign(json_string.length(), ' ');
+  ASSERT_EQ(json.stringValue, "s");
+  ASSERT_EQ(json.json_dump(::xl::json::WRITE_FLAG_PRETTY), SILNGLE_VALUES_JSON);
+
+  const TCHAR *path = _T("json_test_string_view_document.json");
+  ASSERT_EQ(xl::file::write(path, SILNGLE_VALUES_JSON), true);
+  SingleValuesStringView json2;
+  ASSERT_EQ(json2.json_parse_file(path, document), true);
+  xl::json::document document2 = std::move(document);
+  ASSERT_EQ(document.get(), nullptr);
+  ASSERT_EQ(json2.stringValue, "s");
+  ASSERT_EQ(json2.json_dump(::xl::json::WRITE_FLAG_PRETTY), SILNGLE_VALUES_JSON);
+  document2.reset();
+  ASSERT_EQ(xl::file::read(path), SILNGLE_VALUES_JSON);
+  xl::fs::unlink(path);
+}
+
 #endif
 
 namespace {
@@ -1039,6 +1061,35 @@ TEST(json_test, nest_object_values) {
   ASSERT_EQ(json.json_dump(), remove_blanks(NEST_OBJECT_JSON));
 }
 
+TEST(json_test, arena) {
+  xl::json::arena arena;
+  std::string json_string;
+  for (int i = 0; i < 3; ++i) {
+    NestObjectValues json;
+    ASSERT_EQ(json.json_parse(NEST_OBJECT_JSON, arena), true);
+    ASSERT_EQ(json.nestObjectArray.back().intValue, 10);
+    ASSERT_EQ(json.json_dump(json_string, ::xl::json::WRITE_FLAG_PRETTY, arena), true);
+    ASSERT_EQ(json_string, NEST_OBJECT_JSON);
+    ASSERT_EQ(json.json_dump(json_string), true);
+    ASSERT_EQ(json_string, remove_blanks(NEST_OBJECT_JSON));
+  }
+}
+
+TEST(json_test, parse_file) {
+  const TCHAR *path = _T("json_test_parse_file.json");
+  ASSERT_EQ(xl::file::write(path, NEST_OBJECT_JSON), true);
+  NestObjectValues json;
+  ASSERT_EQ(json.json_parse_file(path), true);
+  ASSERT_EQ(json.json_dump(::xl::json::WRITE_FLAG_PRETTY), NEST_OBJECT_JSON);
+  ASSERT_EQ(xl::file::read(path), NEST_OBJECT_JSON);
+  xl::fs::unlink(path);
+
+  NestObjectValues json2;
+  std::string prefix = std::string(NEST_OBJECT_JSON) + "garbage";
+  ASSERT_EQ(json2.json_parse(prefix.c_str(), strlen(NEST_OBJECT_JSON)), true);
+  ASSERT_EQ(json2.json_dump(::xl::json::WRITE_FLAG_PRETTY), NEST_OBJECT_JSON);
+}
+
 TEST(json_test, copy_and_move) {
   SingleValues json;
   ASSERT_EQ(json.json_parse(SILNGLE_VALUES_JSON), true);
@@ -1135,3 +1186,72 @@ TEST(json_test, map_values) {
     }));
   }
 }
+
+namespace {
+
+const char *UNORDERED_KEYS_JSON = R"({
+    "stringValue": "s",
+    "unknownValue": [1, 2, 3],
+    "doubleValue": 2.25,
+    "intValue": -5,
+    "intValue": 5,
+    "boolValue": true
+})";
+
+} // namespace
+
+TEST(json_test, unordered_keys) {
+  SingleValues json;
+  json.uintValue = 6;
+  ASSERT_EQ(json.json_parse(UNORDERED_KEYS_JSON), true);
+  ASSERT_EQ(json.boolValue, true);
+  ASSERT_EQ(json.intValue, -5);
+  ASSERT_EQ(json.uintValue, 0);
+  ASSERT_EQ(json.doubleValue, 2.25);
+  ASSERT_EQ(json.stringValue, "s");
+  ASSERT_EQ(json.json_parse("[]"), false);
+}
+
+TEST(json_test, msgpack) {
+  SimpleObject simple;
+  simple.intValue = -200;
+  ASSERT_EQ(simple.msgpack_dump(), std::string("\x81\xa8intValue\xd1\xff\x38", 13));
+
+  // Round trips through MessagePack give the same JSON back
+  SingleValues single, single2;
+  ASSERT_EQ(single.json_parse(SILNGLE_VALUES_JSON), true);
+  ASSERT_EQ(single2.msgpack_parse(single.msgpack_dump()), true);
+  ASSERT_EQ(single2.json_dump(::xl::json::WRITE_FLAG_PRETTY), SILNGLE_VALUES_JSON);
+
+  NullableValues nullable, nullable2;
+  ASSERT_EQ(nullable.json_parse(HALF_NULL_VALUES_JSON), true);
+  ASSERT_EQ(nullable2.msgpack_parse(nullable.msgpack_dump(::xl::json::WRITE_FLAG_WRITE_NULL_VALUES)), true);
+  ASSERT_EQ(nullable2.json_dump(::xl::json::WRITE_FLAG_PRETTY | ::xl::json::WRITE_FLAG_WRITE_NULL_VALUES),
+            HALF_NULL_VALUES_JSON);
+
+  NestObjectValues nest, nest2;
+  ASSERT_EQ(nest.json_parse(NEST_OBJECT_JSON), true);
+  std::string data;
+  nest.msgpack_dump(data);
+  ASSERT_EQ(nest2.msgpack_parse(data), true);
+  ASSERT_EQ(nest2.json_dump(::xl::json::WRITE_FLAG_PRETTY), NEST_OBJECT_JSON);
+  ASSERT_EQ(nest2.msgpack_parse(data.data(), data.length() - 1), false);
+  ASSERT_EQ(nest2.msgpack_parse(data + '\xc0'), false);
+
+  MapValues map, map2;
+  ASSERT_EQ(map.json_parse(MAP_VALUE_JSON), true);
+  ASSERT_EQ(map2.msgpack_parse(map.msgpack_dump()), true);
+  ASSERT_EQ(map2.json_dump(::xl::json::WRITE_FLAG_PRETTY), MAP_VALUE_JSON);
+
+  // Unknown keys are skipped, whatever they hold, and missing members are read as null
+  std::string unknown("\x83\xa1x\x92\x81\xa1y\xc4\x02..\xcb\0\0\0\0\0\0\0\0"
+                      "\xa8intValue\x2a\xa1z\xc0",
+                      33);
+  simple.intValue = 1;
+  ASSERT_EQ(simple.msgpack_parse(unknown), true);
+  ASSERT_EQ(simple.intValue, 42);
+  ASSERT_EQ(simple.msgpack_parse(std::string("\x80", 1)), true);
+  ASSERT_EQ(simple.intValue, 0);
+  ASSERT_EQ(simple.msgpack_parse(std::string("\x90", 1)), false);
+  ASSERT_EQ(simple.msgpack_parse(std::string("\x81\xa1x\xdd\xff\xff\xff\xff", 8)), false);
+}
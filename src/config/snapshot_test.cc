@@ -0,0 +1,156 @@
+// MIT License
+//
+// Copyright (c) 2022 Streamlet (streamlet@outlook.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <gtest/gtest.h>
+#include <xl/snapshot>
+
+namespace {
+
+XL_REFLECT_BEGIN(Row)
+  XL_REFLECT_MEMBER(int, id)
+  XL_REFLECT_MEMBER(bool, active)
+  XL_REFLECT_MEMBER(double, price)
+  XL_REFLECT_MEMBER(std::string, name)
+  XL_REFLECT_MEMBER(std::vector<int>, tags)
+XL_REFLECT_END()
+
+// Row with price removed, name and id reordered, tags changed to another element type and count added
+XL_REFLECT_BEGIN(RowV2)
+  XL_REFLECT_MEMBER(std::string, name)
+  XL_REFLECT_MEMBER(long long, count)
+  XL_REFLECT_MEMBER(int, id)
+  XL_REFLECT_MEMBER(std::vector<short>, tags)
+  XL_REFLECT_MEMBER(bool, active)
+XL_REFLECT_END()
+
+std::vector<Row> make_rows(int count) {
+  std::vector<Row> rows(count);
+  for (int i = 0; i < count; ++i) {
+    rows[i].id = i;
+    rows[i].active = i % 2 == 0;
+    rows[i].price = i * 1.5;
+    rows[i].name = i % 3 == 0 ? "" : "row" + std::to_string(i);
+    rows[i].tags.assign(i % 4, i);
+  }
+  return rows;
+}
+
+} // namespace
+
+TEST(snapshot_test, normal) {
+  const TCHAR *path = _T("snapshot_test_normal.bin");
+  std::vector<Row> rows = make_rows(100);
+  ASSERT_EQ(xl::snapshot::save(path, rows), true);
+
+  std::vector<Row> loaded;
+  ASSERT_EQ(xl::snapshot::load(path, loaded), true);
+  ASSERT_EQ(loaded.size(), rows.size());
+  for (size_t i = 0; i < rows.size(); ++i) {
+    ASSERT_EQ(loaded[i].id, rows[i].id);
+    ASSERT_EQ(loaded[i].active, rows[i].active);
+    ASSERT_EQ(loaded[i].price, rows[i].price);
+    ASSERT_EQ(loaded[i].name, rows[i].name);
+    ASSERT_EQ(loaded[i].tags, rows[i].tags);
+  }
+
+  xl::snapshot::reader<Row> reader;
+  ASSERT_EQ(reader.open(path), true);
+  ASSERT_EQ(reader.size(), 100);
+  ASSERT_EQ(reader.has_field(4), true);
+  ASSERT_EQ(*reader.data<0>(7), 7);
+  ASSERT_EQ(*reader.data<2>(7), 10.5);
+  ASSERT_EQ(reader.data<0>(100), nullptr);
+  Row row;
+  ASSERT_EQ(reader.read(5, row), true);
+  ASSERT_EQ(row.name, "row5");
+  ASSERT_EQ(reader.read(100, row), false);
+  reader.close();
+
+  // Written to a temporary file and renamed over the old one
+  ASSERT_EQ(xl::snapshot::save(path, std::vector<Row>()), true);
+  ASSERT_EQ(xl::fs::exists(_T("snapshot_test_normal.bin.tmp")), false);
+  ASSERT_EQ(xl::snapshot::load(path, loaded), true);
+  ASSERT_EQ(loaded.empty(), true);
+  xl::fs::unlink(path);
+}
+
+TEST(snapshot_test, schema_evolution) {
+  const TCHAR *path = _T("snapshot_test_schema_evolution.bin");
+  std::vector<Row> rows = make_rows(10);
+  ASSERT_EQ(xl::snapshot::save(path, rows), true);
+
+  xl::snapshot::reader<RowV2> reader;
+  ASSERT_EQ(reader.open(path), true);
+  ASSERT_EQ(reader.has_field(0), true);
+  ASSERT_EQ(reader.has_field(1), false);
+  ASSERT_EQ(reader.has_field(3), false);
+  ASSERT_EQ(reader.data<1>(0), nullptr);
+  RowV2 row;
+  row.count = 1;
+  row.tags.push_back(1);
+  ASSERT_EQ(reader.read(0, row), true);
+  ASSERT_EQ(row.count, 0);
+  ASSERT_EQ(row.tags.empty(), true);
+  std::vector<RowV2> loaded;
+  ASSERT_EQ(reader.read_all(loaded), true);
+  ASSERT_EQ(loaded.size(), 10);
+  for (size_t i = 0; i < rows.size(); ++i) {
+    ASSERT_EQ(loaded[i].id, rows[i].id);
+    ASSERT_EQ(loaded[i].active, rows[i].active);
+    ASSERT_EQ(loaded[i].name, rows[i].name);
+    ASSERT_EQ(loaded[i].tags.empty(), true);
+  }
+  reader.close();
+  xl::fs::unlink(path);
+}
+
+TEST(snapshot_test, invalid) {
+  const TCHAR *path = _T("snapshot_test_invalid.bin");
+  ASSERT_EQ(xl::snapshot::save(path, make_rows(10)), true);
+  std::string data = xl::file::read(path);
+  std::vector<Row> loaded;
+
+  ASSERT_EQ(xl::file::write(path, data.substr(0, data.size() / 2)), true);
+  ASSERT_EQ(xl::snapshot::load(path, loaded), false);
+
+  std::string corrupted = data;
+  corrupted[0] = 'x';
+  ASSERT_EQ(xl::file::write(path, corrupted), true);
+  ASSERT_EQ(xl::snapshot::load(path, loaded), false);
+
+  // The name of row 1 pointing past the heap
+  xl::snapshot::file_header header;
+  memcpy(&header, data.data(), sizeof(header));
+  xl::snapshot::heap_ref ref = {header.heap_size, 1};
+  corrupted = data;
+  memcpy(&corrupted[header.records_offset + header.record_size + xl::snapshot::record_layout<Row>().entry(3).offset],
+         &ref, sizeof(ref));
+  ASSERT_EQ(xl::file::write(path, corrupted), true);
+  xl::snapshot::reader<Row> reader;
+  ASSERT_EQ(reader.open(path), true);
+  Row row;
+  ASSERT_EQ(reader.read(0, row), true);
+  ASSERT_EQ(reader.read(1, row), false);
+  ASSERT_EQ(xl::snapshot::load(path, loaded), false);
+  reader.close();
+  xl::fs::unlink(path);
+}
@@ -33,6 +33,9 @@
 #include <Windows.h>
 #else
 #include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
 #endif
 #ifdef __APPLE__
 #include <sys/errno.h>
@@ -296,6 +299,128 @@ bool write_text_utf16_be(const TCHAR *path, const std::wstring &text) {
   return fwrite_utf16_be(f, text);
 }
 
+mapped_file::mapped_file() : data_(nullptr), size_(0), capacity_(0), empty_() {
+}
+
+mapped_file::~mapped_file() {
+  close();
+}
+
+mapped_file::mapped_file(mapped_file &&that) : data_(that.data_), size_(that.size_), capacity_(that.capacity_) {
+  if (that.data_ == that.empty_) {
+    memcpy(empty_, that.empty_, sizeof(empty_));
+    data_ = empty_;
+  }
+  that.data_ = nullptr;
+  that.size_ = 0;
+  that.capacity_ = 0;
+}
+
+mapped_file &mapped_file::operator=(mapped_file &&that) {
+  if (this != &that) {
+    close();
+    data_ = that.data_;
+    size_ = that.size_;
+    capacity_ = that.capacity_;
+    if (that.data_ == that.empty_) {
+      memcpy(empty_, that.empty_, sizeof(empty_));
+      data_ = empty_;
+    }
+    that.data_ = nullptr;
+    that.size_ = 0;
+    that.capacity_ = 0;
+  }
+  return *this;
+}
+
+// The size is taken from the opened file rather than from path, so that it is the size of the file being mapped
+bool mapped_file::open(const TCHAR *path, bool copy_on_write) {
+  close();
+
+#ifdef _WIN32
+  HANDLE file = CreateFile(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (file == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+  XL_ON_BLOCK_EXIT(CloseHandle, file);
+  LARGE_INTEGER file_size = {};
+  if (!GetFileSizeEx(file, &file_size) || (unsigned long long)file_size.QuadPart > (size_t)-1) {
+    return false;
+  }
+  size_t size = (size_t)file_size.QuadPart;
+  if (size == 0) {
+    open_empty();
+    return true;
+  }
+  HANDLE mapping = CreateFileMapping(file, NULL, copy_on_write ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, NULL);
+  if (mapping == NULL) {
+    return false;
+  }
+  // The view keeps the mapping and the file open
+  XL_ON_BLOCK_EXIT(CloseHandle, mapping);
+  void *view = MapViewOfFile(mapping, copy_on_write ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, (SIZE_T)size);
+  if (view == NULL) {
+    return false;
+  }
+  SYSTEM_INFO system_info = {};
+  GetSystemInfo(&system_info);
+  size_t page_size = system_info.dwPageSize;
+#else
+  int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+  if (fd == -1) {
+    return false;
+  }
+  XL_ON_BLOCK_EXIT(::close, fd);
+  fs::stat_data st = {};
+#if defined(__APPLE__)
+  if (::fstat(fd, &st) != 0) {
+#else
+  if (::fstat64(fd, &st) != 0) {
+#endif
+    return false;
+  }
+  if (!S_ISREG(st.st_mode) || st.st_size < 0 || (unsigned long long)st.st_size > (size_t)-1) {
+    return false;
+  }
+  size_t size = (size_t)st.st_size;
+  if (size == 0) {
+    open_empty();
+    return true;
+  }
+  void *view = mmap(nullptr, size, copy_on_write ? PROT_READ | PROT_WRITE : PROT_READ,
+                    copy_on_write ? MAP_PRIVATE : MAP_SHARED, fd, 0);
+  if (view == MAP_FAILED) {
+    return false;
+  }
+  size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+#endif
+
+  data_ = (char *)view;
+  size_ = size;
+  capacity_ = (size_ + page_size - 1) / page_size * page_size;
+  return true;
+}
+
+void mapped_file::close() {
+  if (data_ != nullptr && data_ != empty_) {
+#ifdef _WIN32
+    UnmapViewOfFile(data_);
+#else
+    munmap(data_, size_);
+#endif
+  }
+  data_ = nullptr;
+  size_ = 0;
+  capacity_ = 0;
+}
+
+void mapped_file::open_empty() {
+  // Cleared, since a copy-on-write mapping may have been written to
+  memset(empty_, 0, sizeof(empty_));
+  data_ = empty_;
+  capacity_ = sizeof(empty_);
+}
+
 } // namespace file
 
 namespace fs {
@@ -493,6 +618,14 @@ bool move(const TCHAR *path, const TCHAR *new_path) {
   return ::_trename(path, new_path) == 0;
 }
 
+bool replace(const TCHAR *path, const TCHAR *new_path) {
+#ifdef _WIN32
+  return ::MoveFileEx(path, new_path, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != FALSE;
+#else
+  return ::rename(path, new_path) == 0;
+#endif
+}
+
 bool copy_file(const TCHAR *path, const TCHAR *new_path) {
   FILE *fin = _tfopen(path, _T("rb"));
   if (fin == NULL) {
@@ -83,6 +83,13 @@ TEST(file_test, fs_operation) {
   ASSERT_EQ(xl::fs::exists(_T("f1")), false);
   ASSERT_EQ(xl::fs::exists(_T("f2")), false);
 
+  ASSERT_EQ(xl::file::write(_T("f"), "f"), true);
+  ASSERT_EQ(xl::fs::touch(_T("f1")), true);
+  ASSERT_EQ(xl::fs::replace(_T("f"), _T("f1")), true);
+  ASSERT_EQ(xl::fs::exists(_T("f")), false);
+  ASSERT_EQ(xl::file::read(_T("f1")), "f");
+  ASSERT_EQ(xl::fs::unlink(_T("f1")), true);
+
   ASSERT_EQ(xl::fs::exists(_T("d")), false);
   ASSERT_EQ(xl::fs::mkdir(_T("d")), true);
   ASSERT_EQ(xl::fs::touch(xl::path::join(_T("d"), _T("f")).c_str()), true);
@@ -289,3 +296,47 @@ TEST(file_test, utf16_be) {
   ASSERT_EQ(xl::file::read_text_auto(_T("f")), "你好");
   ASSERT_EQ(xl::fs::remove(_T("f")), true);
 }
+
+TEST(file_test, mapped_file) {
+  xl::fs::remove(_T("f"));
+
+  xl::file::mapped_file file;
+  ASSERT_EQ(file.open(_T("f")), false);
+  ASSERT_EQ(xl::fs::touch(_T("f")), true);
+  ASSERT_EQ(file.open(_T("f")), true);
+  ASSERT_EQ(file.size(), 0u);
+
+  ASSERT_EQ(xl::file::write(_T("f"), "abc"), true);
+  ASSERT_EQ(file.open(_T("f"), true), true);
+  ASSERT_EQ(std::string(file.data(), file.size()), "abc");
+  ASSERT_EQ(file.capacity() > file.size(), true);
+  ASSERT_EQ(file.data()[file.size()], '\0');
+  file.data()[0] = 'x';
+  ASSERT_EQ(file.data()[0], 'x');
+  ASSERT_EQ(xl::file::read(_T("f")), "abc");
+
+  xl::file::mapped_file moved = std::move(file);
+  ASSERT_EQ(file.is_open(), false);
+  ASSERT_EQ(std::string(moved.data(), moved.size()), "xbc");
+  moved.close();
+
+  // Empty files are backed by storage of each mapped_file
+  ASSERT_EQ(xl::fs::remove(_T("f")), true);
+  ASSERT_EQ(xl::fs::touch(_T("f")), true);
+  ASSERT_EQ(file.open(_T("f"), true), true);
+  ASSERT_EQ(file.size(), 0u);
+  file.data()[0] = 'x';
+  moved = std::move(file);
+  ASSERT_EQ(moved.data()[0], 'x');
+  ASSERT_EQ(file.open(_T("f")), true);
+  ASSERT_EQ(file.data()[0], '\0');
+  ASSERT_EQ(moved.open(_T("f"), true), true);
+  ASSERT_EQ(moved.data()[0], '\0');
+  file.close();
+  moved.close();
+  ASSERT_EQ(xl::fs::remove(_T("f")), true);
+
+  ASSERT_EQ(xl::fs::mkdir(_T("d")), true);
+  ASSERT_EQ(file.open(_T("d")), false);
+  ASSERT_EQ(xl::fs::rmdir(_T("d")), true);
+}
@@ -21,14 +21,24 @@
 // SOFTWARE.
 
 #include "../config/ini.h"
+#include "log_crash_ring.h"
+#include "log_ring.h"
+#include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <chrono>
+#include <climits>
+#include <cstdarg>
+#include <cstdint>
 #include <cstdio>
 #include <cstring>
 #include <ctime>
-#include <iomanip>
+#include <functional>
 #include <map>
+#include <memory>
+#include <vector>
 #include <xl/encoding>
+#include <xl/file>
 #include <xl/ini>
 #include <xl/log>
 #include <xl/log_setup>
@@ -36,10 +46,19 @@
 #include <xl/process>
 #include <xl/scope_exit>
 #include <xl/string>
+#include <xl/synchronous>
 #include <xl/task_thread>
+#include <xl/thread>
+#include <xl/zip>
+#include <yyjson.h>
 
 #ifdef _WIN32
 #include <Windows.h>
+#include <io.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
 #endif
 
 namespace xl {
@@ -48,93 +67,780 @@ namespace log {
 
 namespace {
 
-xl::task_thread log_thread_;
+typedef std::chrono::time_point<std::chrono::system_clock, std::chrono::milliseconds> LogTime;
+
+typedef std::chrono::steady_clock::time_point LogClock;
+
+// Moves a rotated segment out of the way of the live file: zips it if asked, then removes the oldest segments beyond
+// max_files. Runs on the rotation thread.
+void finish_segment(const native_string &log_path, const native_string &segment, unsigned int max_files, bool compress) {
+  if (compress) {
+    native_string zip_file = segment + _T(".zip");
+    if (zip::compress(zip_file.c_str(), segment.c_str())) {
+      fs::unlink(segment.c_str());
+    } else {
+      fs::unlink(zip_file.c_str());
+    }
+  }
+  if (max_files == 0) {
+    return;
+  }
+  native_string dir = path::dirname(log_path.c_str());
+  if (dir.empty()) {
+    dir = path::DOT_STR;
+  }
+  native_string prefix = path::filename(log_path.c_str()) + path::DOT_STR;
+  std::vector<native_string> segments;
+  fs::enum_dir(dir.c_str(), [&](const native_string &name, bool is_dir) {
+    if (!is_dir && name.length() > prefix.length() && name.compare(0, prefix.length(), prefix) == 0 &&
+        name[prefix.length()] >= _T('0') && name[prefix.length()] <= _T('9')) {
+      segments.push_back(name);
+    }
+    return true;
+  });
+  if (segments.size() <= max_files) {
+    return;
+  }
+  // Segment names end with a fixed-width timestamp, so they sort from the oldest
+  std::sort(segments.begin(), segments.end());
+  for (size_t i = 0; i < segments.size() - max_files; ++i) {
+    fs::unlink(path::join(dir, segments[i]).c_str());
+  }
+}
+
+// The log file. On POSIX it is written straight to an O_APPEND descriptor, since records are already batched.
+//
+// When rotation is set up, the live file is renamed to <path>.<YYYYmmdd-HHMMSS-mmm> before a write would take it past
+// max_size, or at the first write in a new hour or day, and a new file is opened at path. Renaming and reopening are
+// the only work done on the log thread; compression and pruning are handed to a background thread.
+class LogFile {
+public:
+  ~LogFile() {
+    close();
+  }
+
+  bool open(const native_string &path) {
+    assert(!is_open());
+    path_ = path;
+    if (!reopen()) {
+      return false;
+    }
+    next_rotation_ = next_rotation_time(time(NULL));
+    return true;
+  }
+
+  bool is_open() const {
+#ifdef _WIN32
+    return file_ != NULL;
+#else
+    return fd_ != -1;
+#endif
+  }
+
+  void set_rotation(unsigned long long max_size, unsigned int max_files, int interval, bool compress) {
+    max_size_ = max_size;
+    max_files_ = max_files;
+    interval_ = interval;
+    compress_ = compress;
+    next_rotation_ = next_rotation_time(time(NULL));
+  }
+
+  // Waits for rotated segments still being compressed
+  void close() {
+    close_file();
+    rotation_thread_.reset();
+  }
+
+  // Drops the data only if the file is closed and cannot be reopened
+  void write(const char *data, size_t length) {
+    if (!is_open() && !reopen()) {
+      return;
+    }
+    if (needs_rotation(length)) {
+      rotate();
+      if (!is_open()) {
+        return;
+      }
+    }
+    size_ += length;
+#ifdef _WIN32
+    fwrite(data, 1, length, file_);
+    fflush(file_);
+#else
+    while (length > 0) {
+      ssize_t written = ::write(fd_, data, length);
+      if (written < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        return;
+      }
+      data += written;
+      length -= written;
+    }
+#endif
+  }
+
+  void sync() {
+#if defined(_WIN32)
+    ::FlushFileBuffers((HANDLE)_get_osfhandle(_fileno(file_)));
+#elif defined(__APPLE__)
+    ::fsync(fd_);
+#else
+    ::fdatasync(fd_);
+#endif
+  }
+
+private:
+  bool open_file() {
+#ifdef _WIN32
+    file_ = _tfopen(path_.c_str(), _T("ab"));
+#else
+    fd_ = ::open(path_.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+#endif
+    return is_open();
+  }
+
+  // Opens the file again after it was closed, at the size it has on disk
+  bool reopen() {
+    if (!open_file()) {
+      return false;
+    }
+    long long size = fs::size(path_.c_str());
+    size_ = size > 0 ? size : 0;
+    return true;
+  }
+
+  void close_file() {
+#ifdef _WIN32
+    if (file_ != NULL) {
+      fclose(file_);
+      file_ = NULL;
+    }
+#else
+    if (fd_ != -1) {
+      ::close(fd_);
+      fd_ = -1;
+    }
+#endif
+  }
+
+  time_t next_rotation_time(time_t now) const {
+    if (interval_ == LOG_ROTATE_NONE) {
+      return 0;
+    }
+    tm t = *std::localtime(&now);
+    t.tm_min = 0;
+    t.tm_sec = 0;
+    if (interval_ == LOG_ROTATE_HOURLY) {
+      t.tm_hour += 1;
+    } else {
+      t.tm_hour = 0;
+      t.tm_mday += 1;
+    }
+    t.tm_isdst = -1;
+    return mktime(&t);
+  }
+
+  bool needs_rotation(size_t length) const {
+    if (size_ == 0) {
+      return false;
+    }
+    if (max_size_ > 0 && size_ + length > max_size_) {
+      return true;
+    }
+    return next_rotation_ != 0 && time(NULL) >= next_rotation_;
+  }
+
+  // Names are taken in increasing order even within a millisecond, so that pruning, which goes by name, never takes a
+  // newer segment for an older one whose name was freed
+  native_string segment_path() {
+    long long milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(
+                                 std::chrono::system_clock::now().time_since_epoch())
+                                 .count();
+    milliseconds = (std::max)(milliseconds, last_segment_milliseconds_ + 1);
+    native_string path;
+    for (;; ++milliseconds) {
+      time_t seconds = (time_t)(milliseconds / 1000);
+      char timestamp[32];
+      size_t length = strftime(timestamp, sizeof(timestamp), "%Y%m%d-%H%M%S", std::localtime(&seconds));
+      char suffix[48];
+      snprintf(suffix, sizeof(suffix), ".%.*s-%03d", (int)length, timestamp, (int)(milliseconds % 1000));
+      path = path_ + native_string(suffix, suffix + strlen(suffix));
+      if (!fs::exists(path.c_str()) && !fs::exists((path + _T(".zip")).c_str())) {
+        break;
+      }
+    }
+    last_segment_milliseconds_ = milliseconds;
+    return path;
+  }
+
+  void rotate() {
+    close_file();
+    native_string segment = segment_path();
+    bool moved = fs::move(path_.c_str(), segment.c_str());
+    if (!open_file()) {
+      // Keep writing to the same file once it can be reopened, rather than leaving a segment behind for nothing
+      if (moved) {
+        fs::move(segment.c_str(), path_.c_str());
+      }
+      reopen();
+      return;
+    }
+    size_ = 0;
+    next_rotation_ = next_rotation_time(time(NULL));
+    if (!moved || (!compress_ && max_files_ == 0)) {
+      return;
+    }
+    if (rotation_thread_ == nullptr) {
+      rotation_thread_.reset(new task_thread);
+    }
+    rotation_thread_->post_task(std::bind(finish_segment, path_, segment, max_files_, compress_));
+  }
+
+private:
+#ifdef _WIN32
+  FILE *file_ = NULL;
+#else
+  int fd_ = -1;
+#endif
+  native_string path_;
+  unsigned long long size_ = 0;
+  unsigned long long max_size_ = 0;
+  unsigned int max_files_ = 0;
+  int interval_ = LOG_ROTATE_NONE;
+  bool compress_ = false;
+  time_t next_rotation_ = 0;
+  long long last_segment_milliseconds_ = 0;
+  std::unique_ptr<task_thread> rotation_thread_;
+};
 
 struct GlobalLogContext {
   std::string app_name = "";
   int level = XL_LOG_LEVEL_OFF;
   unsigned int content = LOG_CONTENT_DEFAULT;
   unsigned int target = LOG_TARGET_ALL;
-  FILE *log_file = NULL;
+  LogFile log_file;
+  long pid = 0;
+
+  int durability = LOG_DURABILITY_DEFAULT;
+  size_t buffer_size = LOG_BUFFER_SIZE_DEFAULT;
+  std::chrono::milliseconds flush_interval{LOG_FLUSH_INTERVAL_DEFAULT};
+
+  // Rendered lines waiting to be written, and when the oldest of them was buffered
+  std::string stdout_buffer;
+  std::string file_buffer;
+  LogClock buffered_since;
+  // Whether the file has been written since it was last synced, and when that was
+  bool unsynced = false;
+  LogClock synced_at;
+};
+
+GlobalLogContext log_context_;
+// Set by setup_format() from any thread, and read by the log thread for each record it renders
+std::atomic<int> log_format_{LOG_FORMAT_DEFAULT};
+
+//
+// Records are handed to the log thread through a bounded lock-free ring of preallocated slots. Each record carries
+// the arguments as encoded by log_va; encodings that do not fit in a slot spill to the heap. Tasks (setup, shutdown)
+// travel through the same ring to keep their order relative to messages, and are never dropped.
+//
 
-  ~GlobalLogContext() {
-    if (log_file != NULL) {
-      fclose(log_file);
-      log_file = NULL;
+const size_t LOG_RING_CAPACITY = 8192;
+const size_t LOG_THREAD_RING_CAPACITY = 256;
+const size_t LOG_RECORD_INLINE_SIZE = 256;
+const unsigned long LOG_IDLE_WAIT_MILLISECONDS = 100;
+const unsigned long LOG_BLOCK_WAIT_MILLISECONDS = 1;
+const size_t LOG_NOTIFY_BLOCKED_INTERVAL = 64;
+
+enum LogRecordKind {
+  LOG_RECORD_MESSAGE,
+  LOG_RECORD_TASK,
+};
+
+struct LogRecord {
+  int kind = LOG_RECORD_MESSAGE;
+  long long stamp = 0; // steady clock, orders records across rings
+  LogTime time;
+  int level = XL_LOG_LEVEL_OFF;
+  const char *file = nullptr;
+  const char *function = nullptr;
+  int line = 0;
+  long tid = 0;
+  size_t length = 0;
+  char data[LOG_RECORD_INLINE_SIZE];
+  std::string *overflow = nullptr;
+  std::function<void()> *task = nullptr;
+};
+
+long long now_stamp() {
+  return std::chrono::steady_clock::now().time_since_epoch().count();
+}
+
+void release_record(LogRecord &record) {
+  delete record.overflow;
+  record.overflow = nullptr;
+  delete record.task;
+  record.task = nullptr;
+}
+
+// Everything below until LogPipeline runs on the log thread only, so the render buffers are reused across records
+
+std::string render_buffer_;
+std::wstring render_wide_buffer_;
+
+// "YYYY-MM-DD hh:mm:ss." of the second last rendered; only the milliseconds change between records within a second
+struct TimePrefixCache {
+  long long second = -1;
+  char text[32];
+  size_t length = 0;
+};
+
+TimePrefixCache time_prefix_cache_;
+
+template <typename T>
+T read_value(const char *&p) {
+  T value;
+  memcpy(&value, p, sizeof(value));
+  p += sizeof(value);
+  return value;
+}
+
+void append_number(std::string &output, const char *format, ...) {
+  char buffer[64];
+  va_list args;
+  va_start(args, format);
+  int length = vsnprintf(buffer, sizeof(buffer), format, args);
+  va_end(args);
+  if (length > 0) {
+    output.append(buffer, (size_t)length < sizeof(buffer) ? length : sizeof(buffer) - 1);
+  }
+}
+
+// Walks the arguments encoded by log_va, passing each value to the matching member of handler
+template <typename Handler>
+void decode_args(const char *args, size_t length, Handler &handler) {
+  const char *p = args;
+  const char *end = args + length;
+  while (p < end) {
+    char type = *p++;
+    switch (type) {
+    case LOG_ARG_INT:
+      handler.on_int(read_value<int64_t>(p));
+      break;
+    case LOG_ARG_UINT:
+      handler.on_uint(read_value<uint64_t>(p));
+      break;
+    case LOG_ARG_DOUBLE:
+      handler.on_double(read_value<double>(p));
+      break;
+    case LOG_ARG_BOOL:
+      handler.on_bool(read_value<bool>(p));
+      break;
+    case LOG_ARG_CHAR:
+      handler.on_string(p, 1);
+      ++p;
+      break;
+    case LOG_ARG_POINTER:
+      handler.on_pointer(read_value<const void *>(p));
+      break;
+    case LOG_ARG_STRING: {
+      uint32_t size = read_value<uint32_t>(p);
+      handler.on_string(p, size);
+      p += size;
+      break;
+    }
+    case LOG_ARG_WSTRING: {
+      uint32_t size = read_value<uint32_t>(p);
+      render_wide_buffer_.resize(size);
+      memcpy(&render_wide_buffer_[0], p, size * sizeof(wchar_t));
+      p += size * sizeof(wchar_t);
+      std::string utf8 = encoding::utf16_to_utf8(render_wide_buffer_.data(), size);
+      handler.on_string(utf8.data(), utf8.length());
+      break;
     }
+    case LOG_ARG_KEY: {
+      uint32_t size = read_value<uint32_t>(p);
+      handler.on_key(p, size);
+      p += size;
+      break;
+    }
+    default:
+      assert(false);
+      return;
+    }
+  }
+}
+
+// Appends arguments as text; a field becomes key=value
+class TextArgs {
+public:
+  explicit TextArgs(std::string &output) : output_(output) {
+  }
+
+  void on_key(const char *key, size_t length) {
+    output_.append(key, length);
+    output_.push_back('=');
   }
+  void on_int(int64_t value) {
+    append_number(output_, "%lld", (long long)value);
+  }
+  void on_uint(uint64_t value) {
+    append_number(output_, "%llu", (unsigned long long)value);
+  }
+  void on_double(double value) {
+    append_number(output_, "%g", value);
+  }
+  void on_bool(bool value) {
+    output_.push_back(value ? '1' : '0');
+  }
+  void on_pointer(const void *value) {
+    append_number(output_, "%p", value);
+  }
+  void on_string(const char *data, size_t length) {
+    output_.append(data, length);
+  }
+
+private:
+  std::string &output_;
 };
 
-GlobalLogContext log_context_;
+// Members written by format_json itself; a field with one of these names is written as "fields.<name>" instead
+static const char *LOG_JSON_RESERVED_KEYS[] = {"time", "level", "app", "file", "function", "line", "pid", "tid",
+                                               "message"};
+const char LOG_JSON_RESERVED_KEY_PREFIX[] = "fields.";
+
+bool is_reserved_json_key(const char *key, size_t length) {
+  for (const char *reserved : LOG_JSON_RESERVED_KEYS) {
+    if (strlen(reserved) == length && memcmp(reserved, key, length) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Adds fields as typed members of object, and appends other arguments as text to message
+class JsonArgs {
+public:
+  JsonArgs(yyjson_mut_doc *doc, yyjson_mut_val *object, std::string &message)
+      : doc_(doc), object_(object), text_(message) {
+  }
+
+  void on_key(const char *key, size_t length) {
+    if (!is_reserved_json_key(key, length)) {
+      key_ = yyjson_mut_strn(doc_, key, length);
+      return;
+    }
+    key_buffer_.assign(LOG_JSON_RESERVED_KEY_PREFIX);
+    key_buffer_.append(key, length);
+    key_ = yyjson_mut_strncpy(doc_, key_buffer_.data(), key_buffer_.length());
+  }
+  void on_int(int64_t value) {
+    if (key_ != nullptr) {
+      add(yyjson_mut_sint(doc_, value));
+    } else {
+      text_.on_int(value);
+    }
+  }
+  void on_uint(uint64_t value) {
+    if (key_ != nullptr) {
+      add(yyjson_mut_uint(doc_, value));
+    } else {
+      text_.on_uint(value);
+    }
+  }
+  void on_double(double value) {
+    if (key_ != nullptr) {
+      add(yyjson_mut_real(doc_, value));
+    } else {
+      text_.on_double(value);
+    }
+  }
+  void on_bool(bool value) {
+    if (key_ != nullptr) {
+      add(yyjson_mut_bool(doc_, value));
+    } else {
+      text_.on_bool(value);
+    }
+  }
+  void on_pointer(const void *value) {
+    if (key_ != nullptr) {
+      char buffer[32];
+      int length = snprintf(buffer, sizeof(buffer), "%p", value);
+      add(yyjson_mut_strncpy(doc_, buffer, length > 0 ? length : 0));
+    } else {
+      text_.on_pointer(value);
+    }
+  }
+  void on_string(const char *data, size_t length) {
+    if (key_ != nullptr) {
+      add(yyjson_mut_strncpy(doc_, data, length));
+    } else {
+      text_.on_string(data, length);
+    }
+  }
+
+private:
+  void add(yyjson_mut_val *value) {
+    yyjson_mut_obj_add(object_, key_, value);
+    key_ = nullptr;
+  }
+
+private:
+  yyjson_mut_doc *doc_;
+  yyjson_mut_val *object_;
+  yyjson_mut_val *key_ = nullptr;
+  std::string key_buffer_;
+  TextArgs text_;
+};
 
 static const char *LOG_LEVEL_STRING[] = {"OFF", "FATAL", "ERROR", "WARN", "INFO", "DEBUG"};
 
-std::string format(std::chrono::time_point<std::chrono::system_clock, std::chrono::milliseconds> time,
-                   int level,
-                   const char *file,
-                   const char *function,
-                   int line,
-                   std::vector<std::string> messages) {
-  std::basic_stringstream<char> ss;
-  const char GROUP_BEGIN = '[';
-  const char GROUP_END = ']';
-  if ((log_context_.content & LOG_CONTENT_TIME) != 0) {
-    ss << GROUP_BEGIN;
+const char GROUP_BEGIN = '[';
+const char GROUP_END = ']';
+
+// Writes "YYYY-MM-DD hh:mm:ss.mmm" into buffer, which must hold LOG_TIME_LENGTH chars, and returns its length
+const size_t LOG_TIME_LENGTH = 32;
+
+size_t format_time(LogTime time, char *buffer) {
+  long long milliseconds = time.time_since_epoch().count();
+  long long second = milliseconds / 1000;
+  if (second != time_prefix_cache_.second) {
     time_t now_t = std::chrono::system_clock::to_time_t(time);
-    ss << std::put_time(std::localtime(&now_t), "%F %T.") << (time.time_since_epoch().count() % 1000);
-    ss << GROUP_END;
+    time_prefix_cache_.length = strftime(time_prefix_cache_.text, sizeof(time_prefix_cache_.text),
+                                         "%Y-%m-%d %H:%M:%S.", std::localtime(&now_t));
+    time_prefix_cache_.second = second;
+  }
+  int millisecond = (int)(milliseconds - second * 1000);
+  size_t length = time_prefix_cache_.length;
+  memcpy(buffer, time_prefix_cache_.text, length);
+  buffer[length++] = (char)('0' + millisecond / 100);
+  buffer[length++] = (char)('0' + millisecond / 10 % 10);
+  buffer[length++] = (char)('0' + millisecond % 10);
+  return length;
+}
+
+const char *level_string(int level) {
+  if (level < XL_LOG_LEVEL_OFF) {
+    level = XL_LOG_LEVEL_OFF;
+  }
+  if (level > XL_LOG_LEVEL_DEBUG) {
+    level = XL_LOG_LEVEL_DEBUG;
+  }
+  return LOG_LEVEL_STRING[level];
+}
+
+const char *short_file_name(const char *file) {
+  const char *file_name = strrchr(file, '/');
+  return file_name == nullptr ? file : file_name + 1;
+}
+
+const char *short_function_name(const char *function) {
+  const char *func_name = strrchr(function, ':');
+  return func_name == nullptr ? function : func_name + 1;
+}
+
+void format_text(std::string &output, const LogRecord &record, const char *args) {
+  if ((log_context_.content & LOG_CONTENT_TIME) != 0) {
+    char time[LOG_TIME_LENGTH];
+    size_t length = format_time(record.time, time);
+    output.push_back(GROUP_BEGIN);
+    output.append(time, length);
+    output.push_back(GROUP_END);
   }
   if ((log_context_.content & LOG_CONTENT_LEVEL) != 0) {
-    ss << GROUP_BEGIN;
-    if (level < XL_LOG_LEVEL_OFF) {
-      level = XL_LOG_LEVEL_OFF;
-    }
-    if (level > XL_LOG_LEVEL_DEBUG) {
-      level = XL_LOG_LEVEL_DEBUG;
-    }
-    ss << LOG_LEVEL_STRING[level];
-    ss << GROUP_END;
+    output.push_back(GROUP_BEGIN);
+    output.append(level_string(record.level));
+    output.push_back(GROUP_END);
   }
   if ((log_context_.content & LOG_CONTENT_APP_NAME) != 0) {
-    ss << GROUP_BEGIN;
-    ss << log_context_.app_name;
-    ss << GROUP_END;
+    output.push_back(GROUP_BEGIN);
+    output.append(log_context_.app_name);
+    output.push_back(GROUP_END);
   }
   if ((log_context_.content & LOG_CONTENT_FULL_FILE_NAME) != 0) {
-    ss << GROUP_BEGIN << file << GROUP_END;
+    output.push_back(GROUP_BEGIN);
+    output.append(record.file);
+    output.push_back(GROUP_END);
   }
   if ((log_context_.content & LOG_CONTENT_FILE_NAME) != 0) {
-    ss << GROUP_BEGIN;
-    const char *file_name = strrchr(file, '/');
-    ss << (file_name == nullptr ? file : file_name + 1);
-    ss << GROUP_END;
+    output.push_back(GROUP_BEGIN);
+    output.append(short_file_name(record.file));
+    output.push_back(GROUP_END);
   }
   if ((log_context_.content & LOG_CONTENT_FULL_FUNC_NAME) != 0) {
-    ss << GROUP_BEGIN << function << GROUP_END;
+    output.push_back(GROUP_BEGIN);
+    output.append(record.function);
+    output.push_back(GROUP_END);
   }
   if ((log_context_.content & LOG_CONTENT_FUNC_NAME) != 0) {
-    ss << GROUP_BEGIN;
-    const char *func_name = strrchr(function, ':');
-    ss << (func_name == nullptr ? function : func_name + 1);
-    ss << GROUP_END;
+    output.push_back(GROUP_BEGIN);
+    output.append(short_function_name(record.function));
+    output.push_back(GROUP_END);
+  }
+  if ((log_context_.content & LOG_CONTENT_LINE) != 0) {
+    output.push_back(GROUP_BEGIN);
+    append_number(output, "L%d", record.line);
+    output.push_back(GROUP_END);
+  }
+  if ((log_context_.content & LOG_CONTENT_PID) != 0) {
+    output.push_back(GROUP_BEGIN);
+    append_number(output, "P%ld", log_context_.pid);
+    output.push_back(GROUP_END);
+  }
+  if ((log_context_.content & LOG_CONTENT_TID) != 0) {
+    output.push_back(GROUP_BEGIN);
+    append_number(output, "T%ld", record.tid);
+    output.push_back(GROUP_END);
+  }
+  TextArgs text(output);
+  decode_args(args, record.length, text);
+  output.push_back('\n');
+}
+
+//
+// JSON records are built in a yyjson document whose memory, including the written text, comes from a pool that is
+// reused for every record, so nothing is allocated per record once the pool is large enough.
+//
+
+const size_t LOG_JSON_POOL_SIZE = 64 * 1024;
+// Room for the values of the largest records, and for escaping every byte of their strings
+const size_t LOG_JSON_POOL_BYTES_PER_ARG_BYTE = 16;
+
+std::vector<char> json_pool_;
+std::string json_message_;
+
+void add_member(yyjson_mut_doc *doc, yyjson_mut_val *object, const char *key, yyjson_mut_val *value) {
+  yyjson_mut_obj_add(object, yyjson_mut_str(doc, key), value);
+}
+
+bool format_json(std::string &output, const LogRecord &record, const char *args) {
+  size_t pool_size = (std::max)(LOG_JSON_POOL_SIZE, record.length * LOG_JSON_POOL_BYTES_PER_ARG_BYTE);
+  if (json_pool_.size() < pool_size) {
+    json_pool_.resize(pool_size);
+  }
+  yyjson_alc alc;
+  if (!yyjson_alc_pool_init(&alc, json_pool_.data(), json_pool_.size())) {
+    return false;
+  }
+  yyjson_mut_doc *doc = yyjson_mut_doc_new(&alc);
+  if (doc == nullptr) {
+    return false;
+  }
+  yyjson_mut_val *object = yyjson_mut_obj(doc);
+  yyjson_mut_doc_set_root(doc, object);
+
+  // Strings referenced without copying must stay alive until the document is written
+  char time[LOG_TIME_LENGTH];
+  if ((log_context_.content & LOG_CONTENT_TIME) != 0) {
+    add_member(doc, object, "time", yyjson_mut_strn(doc, time, format_time(record.time, time)));
+  }
+  if ((log_context_.content & LOG_CONTENT_LEVEL) != 0) {
+    add_member(doc, object, "level", yyjson_mut_str(doc, level_string(record.level)));
+  }
+  if ((log_context_.content & LOG_CONTENT_APP_NAME) != 0) {
+    add_member(doc, object, "app",
+               yyjson_mut_strn(doc, log_context_.app_name.data(), log_context_.app_name.length()));
+  }
+  if ((log_context_.content & LOG_CONTENT_FULL_FILE_NAME) != 0) {
+    add_member(doc, object, "file", yyjson_mut_str(doc, record.file));
+  } else if ((log_context_.content & LOG_CONTENT_FILE_NAME) != 0) {
+    add_member(doc, object, "file", yyjson_mut_str(doc, short_file_name(record.file)));
+  }
+  if ((log_context_.content & LOG_CONTENT_FULL_FUNC_NAME) != 0) {
+    add_member(doc, object, "function", yyjson_mut_str(doc, record.function));
+  } else if ((log_context_.content & LOG_CONTENT_FUNC_NAME) != 0) {
+    add_member(doc, object, "function", yyjson_mut_str(doc, short_function_name(record.function)));
   }
   if ((log_context_.content & LOG_CONTENT_LINE) != 0) {
-    ss << GROUP_BEGIN << 'L' << line << GROUP_END;
+    add_member(doc, object, "line", yyjson_mut_sint(doc, record.line));
   }
   if ((log_context_.content & LOG_CONTENT_PID) != 0) {
-    ss << GROUP_BEGIN << 'P' << xl::process::pid() << GROUP_END;
+    add_member(doc, object, "pid", yyjson_mut_sint(doc, log_context_.pid));
   }
   if ((log_context_.content & LOG_CONTENT_TID) != 0) {
-    ss << GROUP_BEGIN << 'T' << xl::process::tid() << GROUP_END;
+    add_member(doc, object, "tid", yyjson_mut_sint(doc, record.tid));
+  }
+  yyjson_mut_val *message = yyjson_mut_strn(doc, "", 0);
+  add_member(doc, object, "message", message);
+
+  json_message_.clear();
+  JsonArgs fields(doc, object, json_message_);
+  decode_args(args, record.length, fields);
+  yyjson_mut_set_strn(message, json_message_.data(), json_message_.length());
+
+  size_t length = 0;
+  const char *json = yyjson_mut_write_opts(doc, YYJSON_WRITE_ALLOW_INVALID_UNICODE, &alc, &length, nullptr);
+  if (json == nullptr) {
+    return false;
+  }
+  output.append(json, length);
+  output.push_back('\n');
+  return true;
+}
+
+void format(std::string &output, const LogRecord &record, const char *args) {
+  if (log_format_.load(std::memory_order_relaxed) == LOG_FORMAT_JSON && format_json(output, record, args)) {
+    return;
+  }
+  format_text(output, record, args);
+}
+
+void write_buffers() {
+  if (!log_context_.stdout_buffer.empty()) {
+    fwrite(log_context_.stdout_buffer.data(), 1, log_context_.stdout_buffer.length(), stdout);
+    fflush(stdout);
+    log_context_.stdout_buffer.clear();
+  }
+  if (!log_context_.file_buffer.empty()) {
+    log_context_.log_file.write(log_context_.file_buffer.data(), log_context_.file_buffer.length());
+    log_context_.file_buffer.clear();
+    log_context_.unsynced = true;
+  }
+}
+
+void sync_file() {
+  if (log_context_.unsynced && log_context_.log_file.is_open()) {
+    log_context_.log_file.sync();
+  }
+  log_context_.unsynced = false;
+  log_context_.synced_at = std::chrono::steady_clock::now();
+}
+
+// Writes what is due under the durability mode; batch_end is true when the log thread has drained the ring
+void flush(bool batch_end) {
+  LogClock now = std::chrono::steady_clock::now();
+  bool buffered = !log_context_.stdout_buffer.empty() || !log_context_.file_buffer.empty();
+  if (buffered && ((batch_end && log_context_.durability != LOG_DURABILITY_NONE) ||
+                   now - log_context_.buffered_since >= log_context_.flush_interval)) {
+    write_buffers();
   }
-  for (auto &message : messages) {
-    ss << message.c_str();
+  if (log_context_.durability == LOG_DURABILITY_SYNC && log_context_.unsynced &&
+      now - log_context_.synced_at >= log_context_.flush_interval) {
+    sync_file();
   }
-  ss << std::endl;
-  return ss.str();
 }
 
-void print(std::string log) {
+// How long the log thread may sleep before flush has something to do
+unsigned long flush_due_in(unsigned long milliseconds) {
+  LogClock due = LogClock::max();
+  if (!log_context_.stdout_buffer.empty() || !log_context_.file_buffer.empty()) {
+    due = log_context_.buffered_since + log_context_.flush_interval;
+  }
+  if (log_context_.durability == LOG_DURABILITY_SYNC && log_context_.unsynced) {
+    due = (std::min)(due, log_context_.synced_at + log_context_.flush_interval);
+  }
+  if (due == LogClock::max()) {
+    return milliseconds;
+  }
+  auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(due - std::chrono::steady_clock::now());
+  if (remaining.count() <= 0) {
+    return 0;
+  }
+  return (std::min)(milliseconds, (unsigned long)remaining.count());
+}
+
+void print(const std::string &log) {
 #ifdef _WIN32
   if ((log_context_.target & LOG_TARGET_DEBUGGER) != 0) {
     std::wstring s = encoding::utf8_to_utf16(log);
@@ -142,51 +848,423 @@ void print(std::string log) {
   }
 #endif
 
-  if ((log_context_.target & LOG_TARGET_STDOUT) != 0) {
-    printf("%s", log.c_str());
+  bool to_stdout = (log_context_.target & LOG_TARGET_STDOUT) != 0;
+  bool to_file = (log_context_.target & LOG_TARGET_FILE) != 0 && log_context_.log_file.is_open();
+  if (!to_stdout && !to_file) {
+    return;
   }
-
-  if ((log_context_.target & LOG_TARGET_FILE) != 0 && log_context_.log_file != NULL) {
-    fprintf(log_context_.log_file, "%s", log.c_str());
-    fflush(log_context_.log_file);
+  if (log_context_.stdout_buffer.empty() && log_context_.file_buffer.empty()) {
+    log_context_.buffered_since = std::chrono::steady_clock::now();
+  }
+  if (to_stdout) {
+    log_context_.stdout_buffer.append(log);
+  }
+  if (to_file) {
+    log_context_.file_buffer.append(log);
+  }
+  if (log_context_.stdout_buffer.length() >= log_context_.buffer_size ||
+      log_context_.file_buffer.length() >= log_context_.buffer_size) {
+    write_buffers();
   }
 }
 
-void thread_log(std::chrono::time_point<std::chrono::system_clock, std::chrono::milliseconds> time,
-                int level,
-                const char *file,
-                const char *function,
-                int line,
-                std::vector<std::string> messages) {
-  if (log_context_.level < level || log_context_.target == 0) {
+void thread_log(LogRecord &record) {
+  if (log_context_.level < record.level || log_context_.target == 0) {
     return;
   }
-  std::string log = format(time, level, file, function, line, std::move(messages));
-  print(std::move(log));
+  const char *args = record.overflow == nullptr ? record.data : record.overflow->data();
+  render_buffer_.clear();
+  format(render_buffer_, record, args);
+  print(render_buffer_);
+}
+
+// A logging thread's own ring in LOG_QUEUE_PER_THREAD mode. The thread marks it closed when it exits, and the log
+// thread lets it go once it is drained.
+struct ThreadRing {
+  ThreadRing() : ring(LOG_THREAD_RING_CAPACITY) {
+  }
+
+  log_spsc_ring<LogRecord> ring;
+  std::atomic<bool> closed{false};
+};
+
+struct ThreadRingHolder {
+  std::shared_ptr<ThreadRing> ring;
+  unsigned long generation = 0; // of the pipeline the ring was handed to
+
+  ~ThreadRingHolder() {
+    if (ring != nullptr) {
+      ring->closed.store(true, std::memory_order_release);
+    }
+  }
+};
+
+//
+// In LOG_QUEUE_SHARED mode every thread pushes to one ring. In LOG_QUEUE_PER_THREAD mode each thread pushes messages
+// to a ring of its own, so threads never touch each other's cache lines, and the log thread merges the rings by
+// stamp, among the records already pushed. Tasks always go through the shared ring; before the log thread handles a
+// record from it, it handles the per-thread records stamped earlier. This way shutdown() writes everything logged
+// before it was called.
+//
+// stop() ends the log thread, and start() runs a new one for a later setup(); thread rings are handed out again then.
+//
+
+class LogPipeline {
+public:
+  LogPipeline() : ring_(LOG_RING_CAPACITY), wake_(false, true), not_full_(false, true) {
+    start();
+  }
+
+  ~LogPipeline() {
+    stop();
+  }
+
+  void set_overflow(int overflow) {
+    overflow_.store(overflow, std::memory_order_relaxed);
+  }
+
+  void set_queue(int queue) {
+    queue_.store(queue, std::memory_order_relaxed);
+  }
+
+  unsigned long long dropped() const {
+    return dropped_.load(std::memory_order_relaxed);
+  }
+
+  bool post_message(LogTime time,
+                    int level,
+                    const char *file,
+                    const char *function,
+                    int line,
+                    long tid,
+                    const char *args,
+                    size_t length) {
+    if (!accepting_.load(std::memory_order_relaxed)) {
+      return false;
+    }
+    auto fill = [&](LogRecord &record) {
+      record.kind = LOG_RECORD_MESSAGE;
+      record.stamp = now_stamp();
+      record.time = time;
+      record.level = level;
+      record.file = file;
+      record.function = function;
+      record.line = line;
+      record.tid = tid;
+      record.length = length;
+      if (length <= LOG_RECORD_INLINE_SIZE) {
+        memcpy(record.data, args, length);
+      } else {
+        record.overflow = new std::string(args, length);
+      }
+    };
+    if (queue_.load(std::memory_order_relaxed) == LOG_QUEUE_PER_THREAD) {
+      return push_to_thread_ring(fill, overflow_.load(std::memory_order_relaxed));
+    }
+    return push(fill, true, overflow_.load(std::memory_order_relaxed));
+  }
+
+  bool post_task(std::function<void()> &&task) {
+    if (!accepting_.load(std::memory_order_relaxed)) {
+      return false;
+    }
+    return push_task(std::move(task));
+  }
+
+  // Not called concurrently with stop()
+  void start() {
+    if (thread_ != nullptr) {
+      return;
+    }
+    quit_ = false;
+    accepting_.store(true);
+    thread_.reset(new thread(std::bind(&LogPipeline::run, this)));
+  }
+
+  void stop() {
+    if (thread_ == nullptr) {
+      return;
+    }
+    accepting_.store(false);
+    push_task([this]() {
+      quit_ = true;
+    });
+    thread_->join();
+    thread_.reset();
+    generation_.fetch_add(1);
+    while (ring_.try_pop(release_record)) {
+    }
+    collect_thread_rings();
+    for (auto &thread_ring : thread_rings_) {
+      while (LogRecord *record = thread_ring->ring.front()) {
+        release_record(*record);
+        thread_ring->ring.pop();
+      }
+    }
+    thread_rings_.clear();
+  }
+
+private:
+  bool push_task(std::function<void()> &&task) {
+    auto fill = [&](LogRecord &record) {
+      record.kind = LOG_RECORD_TASK;
+      record.stamp = now_stamp();
+      record.task = new std::function<void()>(std::move(task));
+    };
+    return push(fill, false, LOG_OVERFLOW_BLOCK);
+  }
+
+  template <typename Fill>
+  bool push(Fill &fill, bool droppable, int overflow) {
+    auto wait = [this, droppable]() {
+      if (droppable && !accepting_.load(std::memory_order_relaxed)) {
+        return false;
+      }
+      blocked_.fetch_add(1);
+      notify();
+      not_full_.timed_wait(LOG_BLOCK_WAIT_MILLISECONDS);
+      blocked_.fetch_sub(1);
+      return true;
+    };
+    if (!log_ring_push(ring_, fill, droppable, overflow, release_record, wait, dropped_)) {
+      return false;
+    }
+    notify();
+    return true;
+  }
+
+  ThreadRing *thread_ring() {
+    static thread_local ThreadRingHolder holder;
+    unsigned long generation = generation_.load(std::memory_order_relaxed);
+    if (holder.ring == nullptr || holder.generation != generation) {
+      holder.ring = std::make_shared<ThreadRing>();
+      holder.generation = generation;
+      lock_guard lock(new_thread_rings_locker_);
+      new_thread_rings_.push_back(holder.ring);
+      has_new_thread_rings_.store(true);
+    }
+    return holder.ring.get();
+  }
+
+  // Only the log thread takes records out of a thread ring, so the oldest one cannot be dropped here
+  template <typename Fill>
+  bool push_to_thread_ring(Fill &fill, int overflow) {
+    ThreadRing *thread_ring = this->thread_ring();
+    while (!thread_ring->ring.try_push(fill)) {
+      if (overflow != LOG_OVERFLOW_BLOCK || !accepting_.load(std::memory_order_relaxed)) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+      }
+      blocked_.fetch_add(1);
+      notify();
+      not_full_.timed_wait(LOG_BLOCK_WAIT_MILLISECONDS);
+      blocked_.fetch_sub(1);
+    }
+    notify();
+    return true;
+  }
+
+  void notify() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleeping_.load(std::memory_order_relaxed) && sleeping_.exchange(false)) {
+      wake_.set();
+    }
+  }
+
+  void handle(LogRecord &record) {
+    if (record.kind == LOG_RECORD_TASK) {
+      (*record.task)();
+    } else {
+      thread_log(record);
+    }
+    release_record(record);
+    if (++handled_ % LOG_NOTIFY_BLOCKED_INTERVAL == 0) {
+      if (blocked_.load() > 0) {
+        not_full_.set();
+      }
+      flush(false);
+    }
+  }
+
+  void collect_thread_rings() {
+    if (!has_new_thread_rings_.load()) {
+      return;
+    }
+    lock_guard lock(new_thread_rings_locker_);
+    thread_rings_.insert(thread_rings_.end(), new_thread_rings_.begin(), new_thread_rings_.end());
+    new_thread_rings_.clear();
+    has_new_thread_rings_.store(false);
+  }
+
+  // Handles the records in thread rings stamped no later than stamp, oldest first
+  void drain_thread_rings(long long stamp) {
+    collect_thread_rings();
+    if (thread_rings_.empty()) {
+      return;
+    }
+    while (!quit_) {
+      ThreadRing *oldest = nullptr;
+      long long oldest_stamp = 0;
+      long long next_stamp = LLONG_MAX;
+      for (auto &thread_ring : thread_rings_) {
+        LogRecord *record = thread_ring->ring.front();
+        if (record == nullptr) {
+          continue;
+        }
+        if (oldest == nullptr || record->stamp < oldest_stamp) {
+          if (oldest != nullptr) {
+            next_stamp = oldest_stamp;
+          }
+          oldest = thread_ring.get();
+          oldest_stamp = record->stamp;
+        } else if (record->stamp < next_stamp) {
+          next_stamp = record->stamp;
+        }
+      }
+      if (oldest == nullptr || oldest_stamp > stamp) {
+        break;
+      }
+      // Take from the oldest ring for as long as it stays ahead of the others
+      long long limit = (std::min)(next_stamp, stamp);
+      LogRecord *record = nullptr;
+      while (!quit_ && (record = oldest->ring.front()) != nullptr && record->stamp <= limit) {
+        handle(*record);
+        oldest->ring.pop();
+      }
+    }
+    thread_rings_.erase(std::remove_if(thread_rings_.begin(), thread_rings_.end(),
+                                       [](const std::shared_ptr<ThreadRing> &thread_ring) {
+                                         return thread_ring->closed.load(std::memory_order_acquire) &&
+                                                thread_ring->ring.front() == nullptr;
+                                       }),
+                        thread_rings_.end());
+  }
+
+  bool thread_rings_empty() {
+    collect_thread_rings();
+    for (auto &thread_ring : thread_rings_) {
+      if (thread_ring->ring.front() != nullptr) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  void run() {
+    auto consume = [this](LogRecord &record) {
+      drain_thread_rings(record.stamp);
+      if (!quit_) {
+        handle(record);
+      } else {
+        release_record(record);
+      }
+    };
+    while (!quit_) {
+      unsigned long long handled = handled_;
+      while (!quit_ && ring_.try_pop(consume)) {
+      }
+      drain_thread_rings(LLONG_MAX);
+      if (handled_ != handled) {
+        if (blocked_.load() > 0) {
+          not_full_.set();
+        }
+        continue;
+      }
+      flush(true);
+      sleeping_.store(true);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (ring_.empty() && thread_rings_empty()) {
+        wake_.timed_wait(flush_due_in(LOG_IDLE_WAIT_MILLISECONDS));
+      }
+      sleeping_.store(false);
+    }
+    write_buffers();
+  }
+
+private:
+  log_ring<LogRecord> ring_;
+  std::atomic<bool> accepting_{true};
+  std::atomic<bool> sleeping_{false};
+  std::atomic<int> blocked_{0};
+  std::atomic<int> overflow_{LOG_OVERFLOW_DEFAULT};
+  std::atomic<unsigned long long> dropped_{0};
+  std::atomic<int> queue_{LOG_QUEUE_DEFAULT};
+  // Thread rings not yet seen by the log thread
+  locker new_thread_rings_locker_;
+  std::vector<std::shared_ptr<ThreadRing>> new_thread_rings_;
+  std::atomic<bool> has_new_thread_rings_{false};
+  std::atomic<unsigned long> generation_{0};
+  // Log thread only
+  std::vector<std::shared_ptr<ThreadRing>> thread_rings_;
+  unsigned long long handled_ = 0;
+  bool quit_ = false;
+  event wake_;
+  event not_full_;
+  std::unique_ptr<thread> thread_;
+};
+
+LogPipeline log_pipeline_;
+
+log_crash_ring crash_ring_;
+// Set once crash_ring_ is open; producers write to it before handing records to the log thread
+std::atomic<log_crash_ring *> active_crash_ring_{nullptr};
+
+// The caller's thread id, fetched from the system once per thread
+long caller_tid() {
+  static thread_local long tid = xl::process::tid();
+  return tid;
 }
 
 } // namespace
 
-void log(int level, const char *file, const char *function, int line, std::vector<std::string> messages) {
-  log_thread_.post_task(
-      std::bind(thread_log, std::chrono::time_point_cast<std::chrono::milliseconds>(std::chrono::system_clock::now()),
-                level, file, function, line, std::move(messages)));
+std::atomic<int> active_level{XL_LOG_LEVEL_OFF};
+
+log_scratch &thread_log_scratch() {
+  static thread_local log_scratch scratch;
+  return scratch;
+}
+
+void log(int level, const char *file, const char *function, int line, const char *args, size_t length) {
+  LogTime time = std::chrono::time_point_cast<std::chrono::milliseconds>(std::chrono::system_clock::now());
+  long tid = caller_tid();
+  log_crash_ring *crash_ring = active_crash_ring_.load(std::memory_order_acquire);
+  if (crash_ring != nullptr) {
+    crash_ring->write(time.time_since_epoch().count(), level, file, line, tid, args, length);
+  }
+  log_pipeline_.post_message(time, level, file, function, line, tid, args, length);
+}
+
+unsigned long long dropped() {
+  return log_pipeline_.dropped();
 }
 
-void thread_setup(native_string app_name, int level, int content, int target, native_string log_file) {
+void setup_queue(int queue) {
+  log_pipeline_.set_queue(queue);
+}
+
+void setup_format(int format) {
+  log_format_.store(format, std::memory_order_relaxed);
+}
+
+void thread_setup(native_string app_name,
+                  int level,
+                  int content,
+                  int target,
+                  native_string log_file,
+                  int durability,
+                  unsigned int buffer_size,
+                  unsigned int flush_interval) {
   if (level <= XL_LOG_LEVEL_OFF) {
     return;
   }
 
-  FILE *f = NULL;
   if ((target & LOG_TARGET_FILE) != 0 && !log_file.empty()) {
-    f = _tfopen(log_file.c_str(), _T("ab"));
-    if (f == NULL) {
+    if (!log_context_.log_file.open(log_file)) {
+      active_level.store(XL_LOG_LEVEL_OFF);
       return;
     }
   }
 
-  assert(log_context_.log_file == NULL);
 #if defined(_WIN32) && defined(_UNICODE)
   log_context_.app_name = std::move(encoding::utf16_to_utf8(app_name));
 #else
@@ -195,19 +1273,49 @@ void thread_setup(native_string app_name, int level, int content, int target, na
   log_context_.level = level;
   log_context_.content = content;
   log_context_.target = target;
-  log_context_.log_file = f;
+  log_context_.pid = xl::process::pid();
+  log_context_.durability = durability;
+  log_context_.buffer_size = buffer_size;
+  log_context_.flush_interval = std::chrono::milliseconds(flush_interval);
+  log_context_.synced_at = std::chrono::steady_clock::now();
 }
 
-bool setup(const TCHAR *app_name, int level, int content, int target, const TCHAR *log_file) {
+bool setup(const TCHAR *app_name,
+           int level,
+           int content,
+           int target,
+           const TCHAR *log_file,
+           int overflow,
+           int durability,
+           unsigned int buffer_size,
+           unsigned int flush_interval) {
   if (level <= XL_LOG_LEVEL_OFF) {
     return false;
   }
 
-  log_thread_.post_task(std::bind(thread_setup, native_string(app_name == nullptr ? _T("") : app_name), level, content,
-                                  target, native_string(log_file == nullptr ? _T("") : log_file)));
+  log_pipeline_.start();
+  log_pipeline_.set_overflow(overflow);
+  active_level.store(level);
+  return log_pipeline_.post_task(std::bind(thread_setup, native_string(app_name == nullptr ? _T("") : app_name), level,
+                                           content, target, native_string(log_file == nullptr ? _T("") : log_file),
+                                           durability, buffer_size, flush_interval));
+}
+
+bool setup_crash_ring(const TCHAR *ring_file, unsigned int slot_count) {
+  if (ring_file == nullptr || *ring_file == _T('\0') || !crash_ring_.open(ring_file, slot_count)) {
+    return false;
+  }
+  install_log_crash_handler(&crash_ring_);
+  active_crash_ring_.store(&crash_ring_, std::memory_order_release);
   return true;
 }
 
+bool setup_rotation(unsigned long long max_size, unsigned int max_files, int interval, bool compress) {
+  return log_pipeline_.post_task([max_size, max_files, interval, compress]() {
+    log_context_.log_file.set_rotation(max_size, max_files, interval, compress);
+  });
+}
+
 namespace {
 
 string_ref trim_spaces(const string_ref &s) {
@@ -251,6 +1359,18 @@ const char *KEY_LOG_LEVEL = "LogLevel";
 const char *KEY_LOG_CONTENT = "LogContent";
 const char *KEY_LOG_TARGET = "LogTarget";
 const char *KEY_LOG_FILE = "LogFile";
+const char *KEY_LOG_FORMAT = "LogFormat";
+const char *KEY_LOG_OVERFLOW = "LogOverflow";
+const char *KEY_LOG_QUEUE = "LogQueue";
+const char *KEY_LOG_DURABILITY = "LogDurability";
+const char *KEY_LOG_BUFFER_SIZE = "LogBufferSize";
+const char *KEY_LOG_FLUSH_INTERVAL = "LogFlushInterval";
+const char *KEY_MAX_SIZE = "MaxSize";
+const char *KEY_ROTATE_INTERVAL = "RotateInterval";
+const char *KEY_MAX_FILES = "MaxFiles";
+const char *KEY_COMPRESS = "Compress";
+const char *KEY_CRASH_RING_FILE = "CrashRingFile";
+const char *KEY_CRASH_RING_SLOTS = "CrashRingSlots";
 
 const char *VALUE_XL_LOG_LEVEL_OFF = "Off";
 const char *VALUE_XL_LOG_LEVEL_FATAL = "Fatal";
@@ -281,12 +1401,105 @@ const char *VALUE_LOG_TARGET_DEBUGGER = "Debugger";
 const char *VALUE_LOG_TARGET_ALL = "All";
 const char *VALUE_LOG_TARGET_DEFAULT = "Default";
 
+const char *VALUE_LOG_FORMAT_TEXT = "Text";
+const char *VALUE_LOG_FORMAT_JSON = "Json";
+const char *VALUE_LOG_FORMAT_DEFAULT = "Default";
+
+const char *VALUE_LOG_OVERFLOW_BLOCK = "Block";
+const char *VALUE_LOG_OVERFLOW_DROP_NEWEST = "DropNewest";
+const char *VALUE_LOG_OVERFLOW_DROP_OLDEST = "DropOldest";
+const char *VALUE_LOG_OVERFLOW_DEFAULT = "Default";
+
+const char *VALUE_LOG_QUEUE_SHARED = "Shared";
+const char *VALUE_LOG_QUEUE_PER_THREAD = "PerThread";
+const char *VALUE_LOG_QUEUE_DEFAULT = "Default";
+
+const char *VALUE_LOG_DURABILITY_NONE = "None";
+const char *VALUE_LOG_DURABILITY_BATCH = "Batch";
+const char *VALUE_LOG_DURABILITY_SYNC = "Sync";
+const char *VALUE_LOG_DURABILITY_DEFAULT = "Default";
+
+const char *VALUE_ROTATE_NONE = "None";
+const char *VALUE_ROTATE_HOURLY = "Hourly";
+const char *VALUE_ROTATE_DAILY = "Daily";
+
+const char *VALUE_TRUE = "True";
+const char *VALUE_FALSE = "False";
+
+bool parse_unsigned(const string_ref &s, unsigned long long max, unsigned long long &value) {
+  if (s.length() == 0) {
+    return false;
+  }
+  unsigned long long result = 0;
+  for (size_t i = 0; i < s.length(); ++i) {
+    char c = s.data()[i];
+    if (c < '0' || c > '9') {
+      return false;
+    }
+    result = result * 10 + (c - '0');
+    if (result > max) {
+      return false;
+    }
+  }
+  value = result;
+  return true;
+}
+
+bool parse_unsigned(const std::string &s, unsigned int &value) {
+  unsigned long long result = 0;
+  if (!parse_unsigned(trim_spaces(string_ref(s.c_str(), s.length())), 0xffffffffull, result)) {
+    return false;
+  }
+  value = (unsigned int)result;
+  return true;
+}
+
+// A byte count, optionally followed by K, M or G
+bool parse_size(const std::string &s, unsigned long long &value) {
+  string_ref ref = trim_spaces(string_ref(s.c_str(), s.length()));
+  if (ref.length() == 0) {
+    return false;
+  }
+  int shift = 0;
+  switch (ref.data()[ref.length() - 1]) {
+  case 'K':
+    shift = 10;
+    break;
+  case 'M':
+    shift = 20;
+    break;
+  case 'G':
+    shift = 30;
+    break;
+  default:
+    break;
+  }
+  unsigned long long result = 0;
+  if (!parse_unsigned(string_ref(ref.data(), ref.length() - (shift == 0 ? 0 : 1)), 0xffffffffffull, result)) {
+    return false;
+  }
+  value = result << shift;
+  return true;
+}
+
 void parse_settings(const ini_t<char> &ini_file,
                     native_string &app_name,
                     int &level,
                     int &content,
                     int &target,
-                    native_string &log_file) {
+                    native_string &log_file,
+                    int &format,
+                    int &overflow,
+                    int &queue,
+                    int &durability,
+                    unsigned int &buffer_size,
+                    unsigned int &flush_interval,
+                    unsigned long long &max_size,
+                    unsigned int &max_files,
+                    int &rotate_interval,
+                    bool &compress,
+                    native_string &crash_ring_file,
+                    unsigned int &crash_ring_slots) {
   std::string ini_app_name = ini_file.get_value(SECTION_LOG, KEY_APP_NAME);
 #if defined(_WIN32) && defined(_UNICODE)
   app_name = encoding::utf8_to_utf16(ini_app_name);
@@ -381,6 +1594,94 @@ void parse_settings(const ini_t<char> &ini_file,
     log_file = std::move(ini_log_file);
 #endif
   }
+
+  if ((target & (LOG_TARGET_FILE | LOG_TARGET_STDOUT)) != 0) {
+    std::string ini_log_durability = ini_file.get_value(SECTION_LOG, KEY_LOG_DURABILITY);
+    if (ini_log_durability == VALUE_LOG_DURABILITY_NONE) {
+      durability = LOG_DURABILITY_NONE;
+    } else if (ini_log_durability == VALUE_LOG_DURABILITY_BATCH) {
+      durability = LOG_DURABILITY_BATCH;
+    } else if (ini_log_durability == VALUE_LOG_DURABILITY_SYNC) {
+      durability = LOG_DURABILITY_SYNC;
+    } else if (ini_log_durability == VALUE_LOG_DURABILITY_DEFAULT) {
+      durability = LOG_DURABILITY_DEFAULT;
+    } else {
+      // ignore illegal values
+    }
+
+    // illegal numbers leave the defaults
+    parse_unsigned(ini_file.get_value(SECTION_LOG, KEY_LOG_BUFFER_SIZE), buffer_size);
+    parse_unsigned(ini_file.get_value(SECTION_LOG, KEY_LOG_FLUSH_INTERVAL), flush_interval);
+  }
+
+  if ((target & LOG_TARGET_FILE) != 0) {
+    // illegal numbers leave the defaults
+    parse_size(ini_file.get_value(SECTION_LOG, KEY_MAX_SIZE), max_size);
+    parse_unsigned(ini_file.get_value(SECTION_LOG, KEY_MAX_FILES), max_files);
+
+    std::string ini_rotate_interval = ini_file.get_value(SECTION_LOG, KEY_ROTATE_INTERVAL);
+    if (ini_rotate_interval == VALUE_ROTATE_NONE) {
+      rotate_interval = LOG_ROTATE_NONE;
+    } else if (ini_rotate_interval == VALUE_ROTATE_HOURLY) {
+      rotate_interval = LOG_ROTATE_HOURLY;
+    } else if (ini_rotate_interval == VALUE_ROTATE_DAILY) {
+      rotate_interval = LOG_ROTATE_DAILY;
+    } else {
+      // ignore illegal values
+    }
+
+    std::string ini_compress = ini_file.get_value(SECTION_LOG, KEY_COMPRESS);
+    if (ini_compress == VALUE_TRUE) {
+      compress = true;
+    } else if (ini_compress == VALUE_FALSE) {
+      compress = false;
+    } else {
+      // ignore illegal values
+    }
+  }
+
+  std::string ini_log_format = ini_file.get_value(SECTION_LOG, KEY_LOG_FORMAT);
+  if (ini_log_format == VALUE_LOG_FORMAT_TEXT) {
+    format = LOG_FORMAT_TEXT;
+  } else if (ini_log_format == VALUE_LOG_FORMAT_JSON) {
+    format = LOG_FORMAT_JSON;
+  } else if (ini_log_format == VALUE_LOG_FORMAT_DEFAULT) {
+    format = LOG_FORMAT_DEFAULT;
+  } else {
+    // ignore illegal values
+  }
+
+  std::string ini_log_overflow = ini_file.get_value(SECTION_LOG, KEY_LOG_OVERFLOW);
+  if (ini_log_overflow == VALUE_LOG_OVERFLOW_BLOCK) {
+    overflow = LOG_OVERFLOW_BLOCK;
+  } else if (ini_log_overflow == VALUE_LOG_OVERFLOW_DROP_NEWEST) {
+    overflow = LOG_OVERFLOW_DROP_NEWEST;
+  } else if (ini_log_overflow == VALUE_LOG_OVERFLOW_DROP_OLDEST) {
+    overflow = LOG_OVERFLOW_DROP_OLDEST;
+  } else if (ini_log_overflow == VALUE_LOG_OVERFLOW_DEFAULT) {
+    overflow = LOG_OVERFLOW_DEFAULT;
+  } else {
+    // ignore illegal values
+  }
+
+  std::string ini_log_queue = ini_file.get_value(SECTION_LOG, KEY_LOG_QUEUE);
+  if (ini_log_queue == VALUE_LOG_QUEUE_SHARED) {
+    queue = LOG_QUEUE_SHARED;
+  } else if (ini_log_queue == VALUE_LOG_QUEUE_PER_THREAD) {
+    queue = LOG_QUEUE_PER_THREAD;
+  } else if (ini_log_queue == VALUE_LOG_QUEUE_DEFAULT) {
+    queue = LOG_QUEUE_DEFAULT;
+  } else {
+    // ignore illegal values
+  }
+
+  std::string ini_crash_ring_file = ini_file.get_value(SECTION_LOG, KEY_CRASH_RING_FILE);
+#if defined(_WIN32) && defined(_UNICODE)
+  crash_ring_file = encoding::utf8_to_utf16(ini_crash_ring_file);
+#else
+  crash_ring_file = std::move(ini_crash_ring_file);
+#endif
+  parse_unsigned(ini_file.get_value(SECTION_LOG, KEY_CRASH_RING_SLOTS), crash_ring_slots);
 }
 
 } // namespace
@@ -396,22 +1697,53 @@ bool setup_from_file(const TCHAR *log_setting_file) {
   int content = LOG_CONTENT_DEFAULT;
   int target = LOG_TARGET_ALL;
   native_string log_file;
-  parse_settings(ini_file, app_name, level, content, target, log_file);
+  int format = LOG_FORMAT_DEFAULT;
+  int overflow = LOG_OVERFLOW_DEFAULT;
+  int queue = LOG_QUEUE_DEFAULT;
+  int durability = LOG_DURABILITY_DEFAULT;
+  unsigned int buffer_size = LOG_BUFFER_SIZE_DEFAULT;
+  unsigned int flush_interval = LOG_FLUSH_INTERVAL_DEFAULT;
+  unsigned long long max_size = 0;
+  unsigned int max_files = 0;
+  int rotate_interval = LOG_ROTATE_NONE;
+  bool compress = false;
+  native_string crash_ring_file;
+  unsigned int crash_ring_slots = LOG_CRASH_RING_SLOTS_DEFAULT;
+  parse_settings(ini_file, app_name, level, content, target, log_file, format, overflow, queue, durability,
+                 buffer_size, flush_interval, max_size, max_files, rotate_interval, compress, crash_ring_file,
+                 crash_ring_slots);
 
-  return setup(app_name.c_str(), level, content, target, log_file.c_str());
+  setup_queue(queue);
+  setup_format(format);
+  if (!setup(app_name.c_str(), level, content, target, log_file.c_str(), overflow, durability, buffer_size,
+             flush_interval)) {
+    return false;
+  }
+  if (max_size > 0 || rotate_interval != LOG_ROTATE_NONE) {
+    setup_rotation(max_size, max_files, rotate_interval, compress);
+  }
+  if (!crash_ring_file.empty()) {
+    setup_crash_ring(crash_ring_file.c_str(), crash_ring_slots);
+  }
+  return true;
 }
 
 void thread_shutdown() {
-  if (log_context_.log_file != NULL) {
-    fclose(log_context_.log_file);
-    log_context_.log_file = NULL;
+  write_buffers();
+  if (log_context_.durability == LOG_DURABILITY_SYNC) {
+    sync_file();
   }
-  log_thread_.quit();
+  log_context_.log_file.close();
+  log_context_.log_file.set_rotation(0, 0, LOG_ROTATE_NONE, false);
 }
 
 void shutdown() {
-  log_thread_.post_task(thread_shutdown);
-  log_thread_.join();
+  active_level.store(XL_LOG_LEVEL_OFF);
+  log_pipeline_.post_task(thread_shutdown);
+  log_pipeline_.stop();
+  if (active_crash_ring_.exchange(nullptr) != nullptr) {
+    crash_ring_.close();
+  }
 }
 
 } // namespace log
@@ -0,0 +1,474 @@
+// MIT License
+//
+// Copyright (c) 2022 Streamlet (streamlet@outlook.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "log_crash_ring.h"
+#include <algorithm>
+#include <csignal>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <xl/encoding>
+#include <xl/file>
+#include <xl/log>
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace xl {
+
+namespace log {
+
+namespace {
+
+const char LOG_CRASH_RING_MAGIC[8] = {'X', 'L', 'L', 'O', 'G', 'R', 'N', 'G'};
+
+// Length of the leading whole arguments in args that fit in capacity bytes
+size_t fitting_length(const char *args, size_t length, size_t capacity) {
+  size_t fit = 0;
+  while (fit < length) {
+    size_t size = 1;
+    uint32_t count = 0;
+    switch (args[fit]) {
+    case LOG_ARG_INT:
+    case LOG_ARG_UINT:
+      size += 8;
+      break;
+    case LOG_ARG_DOUBLE:
+      size += sizeof(double);
+      break;
+    case LOG_ARG_CHAR:
+      size += 1;
+      break;
+    case LOG_ARG_POINTER:
+      size += sizeof(const void *);
+      break;
+    case LOG_ARG_BOOL:
+      size += sizeof(bool);
+      break;
+    case LOG_ARG_STRING:
+    case LOG_ARG_KEY:
+      memcpy(&count, args + fit + 1, sizeof(count));
+      size += sizeof(count) + count;
+      break;
+    case LOG_ARG_WSTRING:
+      memcpy(&count, args + fit + 1, sizeof(count));
+      size += sizeof(count) + count * sizeof(wchar_t);
+      break;
+    default:
+      return fit;
+    }
+    if (fit + size > capacity) {
+      break;
+    }
+    fit += size;
+  }
+  return fit;
+}
+
+// Moves a ring that was not shut down cleanly out of the way, so that restarting a crashed process keeps the records
+void keep_unclosed_ring(const native_string &path) {
+  FILE *f = _tfopen(path.c_str(), _T("rb"));
+  if (f == NULL) {
+    return;
+  }
+  std::string ring(sizeof(log_crash_ring_header), '\0');
+  bool read = fread(&ring[0], 1, ring.size(), f) == ring.size();
+  fclose(f);
+  if (!read) {
+    return;
+  }
+  const log_crash_ring_header *header = (const log_crash_ring_header *)ring.data();
+  if (memcmp(header->magic, LOG_CRASH_RING_MAGIC, sizeof(header->magic)) != 0 ||
+      header->state == LOG_CRASH_RING_CLOSED) {
+    return;
+  }
+  native_string previous = path + _T(".prev");
+  fs::unlink(previous.c_str());
+  fs::move(path.c_str(), previous.c_str());
+}
+
+} // namespace
+
+log_crash_ring::log_crash_ring()
+    : header_(nullptr), slots_(nullptr), mask_(0), mapped_size_(0)
+#ifdef _WIN32
+      ,
+      file_(INVALID_HANDLE_VALUE), mapping_(NULL)
+#endif
+{
+}
+
+log_crash_ring::~log_crash_ring() {
+  // Not unmapped, for the same reason as in close()
+}
+
+bool log_crash_ring::open(const native_string &path, unsigned int slot_count) {
+  if (header_ != nullptr) {
+    return false;
+  }
+  size_t count = 2;
+  while (count < slot_count) {
+    count <<= 1;
+  }
+  size_t size = (count + 1) * LOG_CRASH_SLOT_SIZE;
+  keep_unclosed_ring(path);
+
+#ifdef _WIN32
+  HANDLE file = CreateFile(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS,
+                           FILE_ATTRIBUTE_NORMAL, NULL);
+  if (file == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+  HANDLE mapping = CreateFileMapping(file, NULL, PAGE_READWRITE, (DWORD)((unsigned long long)size >> 32),
+                                     (DWORD)(size & 0xffffffff), NULL);
+  if (mapping == NULL) {
+    CloseHandle(file);
+    return false;
+  }
+  void *view = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, size);
+  if (view == NULL) {
+    CloseHandle(mapping);
+    CloseHandle(file);
+    return false;
+  }
+  file_ = file;
+  mapping_ = mapping;
+#else
+  int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd == -1) {
+    return false;
+  }
+  if (ftruncate(fd, (off_t)size) != 0) {
+    ::close(fd);
+    return false;
+  }
+  void *view = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  // The mapping keeps the file
+  ::close(fd);
+  if (view == MAP_FAILED) {
+    return false;
+  }
+#endif
+
+  // A new file reads as zeros, so every slot starts out incomplete
+  log_crash_ring_header *header = (log_crash_ring_header *)view;
+  memcpy(header->magic, LOG_CRASH_RING_MAGIC, sizeof(header->magic));
+  header->version = LOG_CRASH_RING_VERSION;
+  header->slot_size = LOG_CRASH_SLOT_SIZE;
+  header->slot_count = (uint32_t)count;
+  header->state = LOG_CRASH_RING_RUNNING;
+  header->signal = 0;
+#ifdef _WIN32
+  header->pid = GetCurrentProcessId();
+#else
+  header->pid = getpid();
+#endif
+  header->next.store(0, std::memory_order_relaxed);
+
+  slots_ = (log_crash_slot *)((char *)view + LOG_CRASH_SLOT_SIZE);
+  mask_ = count - 1;
+  mapped_size_ = size;
+  header_ = header;
+  return true;
+}
+
+void log_crash_ring::write(long long time,
+                           int level,
+                           const char *file,
+                           int line,
+                           long tid,
+                           const char *args,
+                           size_t length) {
+  uint64_t number = header_->next.fetch_add(1, std::memory_order_relaxed);
+  log_crash_slot &slot = slots_[number & mask_];
+  slot.sequence.store(0, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  slot.time = time;
+  slot.level = level;
+  slot.line = line;
+  slot.tid = tid;
+  const char *file_name = strrchr(file, '/');
+  file_name = file_name == nullptr ? file : file_name + 1;
+  size_t file_name_length = strlen(file_name);
+  if (file_name_length >= sizeof(slot.file)) {
+    file_name_length = sizeof(slot.file) - 1;
+  }
+  memcpy(slot.file, file_name, file_name_length);
+  slot.file[file_name_length] = '\0';
+  size_t fit = fitting_length(args, length, sizeof(slot.data));
+  memcpy(slot.data, args, fit);
+  slot.length = (uint32_t)fit;
+  slot.truncated = fit < length ? 1 : 0;
+  slot.sequence.store(number + 1, std::memory_order_release);
+}
+
+void log_crash_ring::close() {
+  if (header_ == nullptr) {
+    return;
+  }
+  header_->state = LOG_CRASH_RING_CLOSED;
+}
+
+void log_crash_ring::crash(int signal) {
+  if (header_ == nullptr) {
+    return;
+  }
+  header_->signal = signal;
+  header_->state = LOG_CRASH_RING_CRASHED;
+  // Dirty pages of a shared mapping outlive the process anyway; this also gets them past a system crash
+#ifdef _WIN32
+  FlushViewOfFile(header_, mapped_size_);
+  FlushFileBuffers(file_);
+#else
+  msync(header_, mapped_size_, MS_SYNC);
+#endif
+}
+
+namespace {
+
+const char *LEVEL_STRING[] = {"OFF", "FATAL", "ERROR", "WARN", "INFO", "DEBUG"};
+
+template <typename T>
+bool read_value(const char *&p, const char *end, T &value) {
+  if ((size_t)(end - p) < sizeof(value)) {
+    return false;
+  }
+  memcpy(&value, p, sizeof(value));
+  p += sizeof(value);
+  return true;
+}
+
+void append_number(std::string &output, const char *format, ...) {
+  char buffer[64];
+  va_list args;
+  va_start(args, format);
+  int length = vsnprintf(buffer, sizeof(buffer), format, args);
+  va_end(args);
+  if (length > 0) {
+    output.append(buffer, (size_t)length < sizeof(buffer) ? length : sizeof(buffer) - 1);
+  }
+}
+
+// Renders arguments as xl::log does in text format, stopping at anything malformed
+void decode_args(const char *p, const char *end, std::string &output) {
+  while (p < end) {
+    char type = *p++;
+    switch (type) {
+    case LOG_ARG_INT: {
+      int64_t value = 0;
+      if (!read_value(p, end, value)) {
+        return;
+      }
+      append_number(output, "%lld", (long long)value);
+      break;
+    }
+    case LOG_ARG_UINT: {
+      uint64_t value = 0;
+      if (!read_value(p, end, value)) {
+        return;
+      }
+      append_number(output, "%llu", (unsigned long long)value);
+      break;
+    }
+    case LOG_ARG_DOUBLE: {
+      double value = 0;
+      if (!read_value(p, end, value)) {
+        return;
+      }
+      append_number(output, "%g", value);
+      break;
+    }
+    case LOG_ARG_BOOL: {
+      bool value = false;
+      if (!read_value(p, end, value)) {
+        return;
+      }
+      output.push_back(value ? '1' : '0');
+      break;
+    }
+    case LOG_ARG_CHAR: {
+      char value = 0;
+      if (!read_value(p, end, value)) {
+        return;
+      }
+      output.push_back(value);
+      break;
+    }
+    case LOG_ARG_POINTER: {
+      const void *value = nullptr;
+      if (!read_value(p, end, value)) {
+        return;
+      }
+      append_number(output, "%p", value);
+      break;
+    }
+    case LOG_ARG_STRING:
+    case LOG_ARG_KEY: {
+      uint32_t size = 0;
+      if (!read_value(p, end, size) || (size_t)(end - p) < size) {
+        return;
+      }
+      output.append(p, size);
+      if (type == LOG_ARG_KEY) {
+        output.push_back('=');
+      }
+      p += size;
+      break;
+    }
+    case LOG_ARG_WSTRING: {
+      uint32_t size = 0;
+      if (!read_value(p, end, size) || (size_t)(end - p) / sizeof(wchar_t) < size) {
+        return;
+      }
+      std::wstring wide(size, L'\0');
+      memcpy(&wide[0], p, size * sizeof(wchar_t));
+      output.append(encoding::utf16_to_utf8(wide));
+      p += size * sizeof(wchar_t);
+      break;
+    }
+    default:
+      return;
+    }
+  }
+}
+
+} // namespace
+
+const log_crash_ring_header *log_crash_ring_file_header(const std::string &ring) {
+  if (ring.size() < LOG_CRASH_SLOT_SIZE) {
+    return nullptr;
+  }
+  const log_crash_ring_header *header = (const log_crash_ring_header *)ring.data();
+  if (memcmp(header->magic, LOG_CRASH_RING_MAGIC, sizeof(header->magic)) != 0 ||
+      header->version != LOG_CRASH_RING_VERSION || header->slot_size != LOG_CRASH_SLOT_SIZE ||
+      header->slot_count == 0 || (header->slot_count & (header->slot_count - 1)) != 0 ||
+      ring.size() < ((size_t)header->slot_count + 1) * LOG_CRASH_SLOT_SIZE) {
+    return nullptr;
+  }
+  return header;
+}
+
+std::vector<const log_crash_slot *> log_crash_ring_file_records(const std::string &ring) {
+  const log_crash_ring_header *header = (const log_crash_ring_header *)ring.data();
+  uint64_t next = header->next.load();
+  uint64_t first = next > header->slot_count ? next - header->slot_count : 0;
+  const log_crash_slot *slots = (const log_crash_slot *)(ring.data() + LOG_CRASH_SLOT_SIZE);
+  std::vector<const log_crash_slot *> records;
+  for (uint32_t i = 0; i < header->slot_count; ++i) {
+    uint64_t sequence = slots[i].sequence.load();
+    if (sequence == 0 || sequence > next || sequence - 1 < first || ((sequence - 1) & (header->slot_count - 1)) != i) {
+      continue;
+    }
+    records.push_back(&slots[i]);
+  }
+  std::sort(records.begin(), records.end(), [](const log_crash_slot *lhs, const log_crash_slot *rhs) {
+    return lhs->sequence.load() < rhs->sequence.load();
+  });
+  return records;
+}
+
+std::string format_log_crash_slot(const log_crash_slot &slot) {
+  std::string line;
+  time_t seconds = (time_t)(slot.time / 1000);
+  char time_text[32] = {};
+  strftime(time_text, sizeof(time_text), "%Y-%m-%d %H:%M:%S", localtime(&seconds));
+  append_number(line, "[%s.%03d]", time_text, (int)(slot.time % 1000));
+  int level = slot.level;
+  if (level < 0 || level >= (int)(sizeof(LEVEL_STRING) / sizeof(LEVEL_STRING[0]))) {
+    level = 0;
+  }
+  append_number(line, "[%s]", LEVEL_STRING[level]);
+  std::string file(slot.file, strnlen(slot.file, sizeof(slot.file)));
+  line.push_back('[');
+  line.append(file);
+  append_number(line, ":L%d][T%lld]", slot.line, (long long)slot.tid);
+  size_t length = slot.length < sizeof(slot.data) ? slot.length : sizeof(slot.data);
+  decode_args(slot.data, slot.data + length, line);
+  if (slot.truncated != 0) {
+    line.append("...");
+  }
+  return line;
+}
+
+namespace {
+
+log_crash_ring *crash_ring_ = nullptr;
+
+#ifdef _WIN32
+
+LPTOP_LEVEL_EXCEPTION_FILTER previous_filter_ = NULL;
+void(__cdecl *previous_abort_handler_)(int) = SIG_DFL;
+
+LONG WINAPI crash_filter(EXCEPTION_POINTERS *exception) {
+  crash_ring_->crash((int)exception->ExceptionRecord->ExceptionCode);
+  return previous_filter_ != NULL ? previous_filter_(exception) : EXCEPTION_CONTINUE_SEARCH;
+}
+
+void __cdecl abort_handler(int signal) {
+  crash_ring_->crash(signal);
+  ::signal(SIGABRT, previous_abort_handler_);
+  raise(signal);
+}
+
+#else
+
+const int CRASH_SIGNALS[] = {SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT};
+struct sigaction previous_actions_[sizeof(CRASH_SIGNALS) / sizeof(CRASH_SIGNALS[0])];
+
+void crash_handler(int signal) {
+  crash_ring_->crash(signal);
+  for (size_t i = 0; i < sizeof(CRASH_SIGNALS) / sizeof(CRASH_SIGNALS[0]); ++i) {
+    if (CRASH_SIGNALS[i] == signal) {
+      sigaction(signal, &previous_actions_[i], nullptr);
+    }
+  }
+  // Delivered again once this handler returns, since it is blocked while the handler runs
+  raise(signal);
+}
+
+#endif
+
+} // namespace
+
+void install_log_crash_handler(log_crash_ring *ring) {
+  crash_ring_ = ring;
+#ifdef _WIN32
+  previous_filter_ = SetUnhandledExceptionFilter(crash_filter);
+  previous_abort_handler_ = signal(SIGABRT, abort_handler);
+#else
+  struct sigaction action = {};
+  action.sa_handler = crash_handler;
+  sigemptyset(&action.sa_mask);
+  for (size_t i = 0; i < sizeof(CRASH_SIGNALS) / sizeof(CRASH_SIGNALS[0]); ++i) {
+    sigaction(CRASH_SIGNALS[i], &action, &previous_actions_[i]);
+  }
+#endif
+}
+
+} // namespace log
+
+} // namespace xl
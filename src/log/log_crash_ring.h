@@ -0,0 +1,127 @@
+// MIT License
+//
+// Copyright (c) 2022 Streamlet (streamlet@outlook.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <xl/native_string>
+
+namespace xl {
+
+namespace log {
+
+//
+// Crash ring file layout, shared with tools/log_crash_decode.
+//
+// A header slot is followed by slot_count record slots. Producers claim the next record number from the header and
+// copy the encoded arguments of their record straight into slot (number % slot_count), so the records survive in the
+// page cache when the process is killed. The signal stored in the header tells a crash from a clean shutdown.
+//
+
+const uint32_t LOG_CRASH_RING_VERSION = 1;
+const size_t LOG_CRASH_SLOT_SIZE = 512;
+const size_t LOG_CRASH_FILE_NAME_SIZE = 32;
+
+enum LogCrashRingState {
+  LOG_CRASH_RING_RUNNING = 0,
+  LOG_CRASH_RING_CLOSED = 1,
+  LOG_CRASH_RING_CRASHED = 2,
+};
+
+struct log_crash_ring_header {
+  char magic[8]; // "XLLOGRNG"
+  uint32_t version;
+  uint32_t slot_size;
+  uint32_t slot_count; // a power of 2
+  int32_t state;
+  int32_t signal; // the signal, or on Windows the exception code, that crashed the process
+  int32_t reserved;
+  int64_t pid;
+  std::atomic<uint64_t> next; // records claimed so far
+};
+
+struct log_crash_slot {
+  std::atomic<uint64_t> sequence; // record number + 1 once complete, 0 while being written
+  int64_t time;                   // milliseconds since the epoch
+  int32_t level;
+  int32_t line;
+  int64_t tid;
+  uint32_t length;    // bytes of encoded arguments in data
+  uint32_t truncated; // 1 if the arguments after them did not fit
+  char file[LOG_CRASH_FILE_NAME_SIZE];
+  char data[LOG_CRASH_SLOT_SIZE - 72];
+};
+
+static_assert(sizeof(log_crash_ring_header) <= LOG_CRASH_SLOT_SIZE, "crash ring header must fit in a slot");
+static_assert(sizeof(log_crash_slot) == LOG_CRASH_SLOT_SIZE, "unexpected crash ring slot size");
+
+// The mapped crash ring of this process
+class log_crash_ring {
+public:
+  log_crash_ring();
+  ~log_crash_ring();
+
+  log_crash_ring(const log_crash_ring &) = delete;
+  log_crash_ring &operator=(const log_crash_ring &) = delete;
+
+  // Creates or truncates path, and maps it. A ring at path left by a process that crashed, or is still running or was
+  // killed, is first moved to <path>.prev.
+  bool open(const native_string &path, unsigned int slot_count);
+  // Called on any thread
+  void write(long long time, int level, const char *file, int line, long tid, const char *args, size_t length);
+  // Marks a clean shutdown. The mapping is kept, as other threads may still be writing.
+  void close();
+
+  // Marks the crash, pushes the mapping to disk and returns; async-signal-safe
+  void crash(int signal);
+
+private:
+  log_crash_ring_header *header_;
+  log_crash_slot *slots_;
+  size_t mask_;
+  size_t mapped_size_;
+#ifdef _WIN32
+  void *file_;
+  void *mapping_;
+#endif
+};
+
+// Reading a ring file loaded into memory, as tools/log_crash_decode does
+
+// The header of ring, or nullptr if it is not a crash ring of this version
+const log_crash_ring_header *log_crash_ring_file_header(const std::string &ring);
+// The complete slots holding the last slot_count records claimed, oldest first; ring must have a valid header
+std::vector<const log_crash_slot *> log_crash_ring_file_records(const std::string &ring);
+// The record as a text line, "..." standing for arguments that did not fit in the slot
+std::string format_log_crash_slot(const log_crash_slot &slot);
+
+// Installs handlers for fatal signals, and on Windows an unhandled exception filter, that call ring->crash() and then
+// hand the signal to the handler installed before
+void install_log_crash_handler(log_crash_ring *ring);
+
+} // namespace log
+
+} // namespace xl
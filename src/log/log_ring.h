@@ -0,0 +1,242 @@
+// MIT License
+//
+// Copyright (c) 2022 Streamlet (streamlet@outlook.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <xl/log_setup>
+
+namespace xl {
+
+namespace log {
+
+inline size_t log_ring_capacity(size_t capacity) {
+  size_t n = 2;
+  while (n < capacity) {
+    n <<= 1;
+  }
+  return n;
+}
+
+//
+// Bounded lock-free ring with preallocated slots, based on Dmitry Vyukov's bounded MPMC queue.
+//
+// Producers construct values in place, so pushing never allocates. The log thread is the regular consumer; producers
+// only pop when they drop the oldest value on overflow, and values pushed as non-droppable are never dropped that way.
+//
+
+template <typename T>
+class log_ring {
+public:
+  explicit log_ring(size_t capacity) : mask_(log_ring_capacity(capacity) - 1), cells_(new cell[mask_ + 1]) {
+    for (size_t i = 0; i <= mask_; ++i) {
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    enqueue_pos_.store(0, std::memory_order_relaxed);
+    dequeue_pos_.store(0, std::memory_order_relaxed);
+  }
+
+  log_ring(const log_ring &) = delete;
+  log_ring &operator=(const log_ring &) = delete;
+
+  size_t capacity() const {
+    return mask_ + 1;
+  }
+
+  template <typename Fill>
+  bool try_push(Fill fill, bool droppable = true) {
+    size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    cell *c = nullptr;
+    while (true) {
+      c = &cells_[pos & mask_];
+      size_t seq = c->sequence.load(std::memory_order_acquire);
+      intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+      if (diff == 0) {
+        if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = enqueue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+    fill(c->value);
+    c->droppable.store(droppable, std::memory_order_relaxed);
+    c->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  template <typename Consume>
+  bool try_pop(Consume consume) {
+    return pop(consume, false);
+  }
+
+  // Pops the oldest value only if it was pushed as droppable
+  template <typename Consume>
+  bool try_drop_oldest(Consume consume) {
+    return pop(consume, true);
+  }
+
+  bool empty() const {
+    size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+    size_t seq = cells_[pos & mask_].sequence.load(std::memory_order_acquire);
+    return (intptr_t)seq - (intptr_t)(pos + 1) < 0;
+  }
+
+private:
+  template <typename Consume>
+  bool pop(Consume &consume, bool droppable_only) {
+    size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+    cell *c = nullptr;
+    while (true) {
+      c = &cells_[pos & mask_];
+      size_t seq = c->sequence.load(std::memory_order_acquire);
+      intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+      if (diff == 0) {
+        if (droppable_only && !c->droppable.load(std::memory_order_relaxed)) {
+          return false;
+        }
+        if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = dequeue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+    consume(c->value);
+    c->sequence.store(pos + mask_ + 1, std::memory_order_release);
+    return true;
+  }
+
+  static const size_t CACHE_LINE_SIZE = 64;
+
+  struct cell {
+    std::atomic<size_t> sequence;
+    std::atomic<bool> droppable;
+    T value;
+  };
+
+  const size_t mask_;
+  std::unique_ptr<cell[]> cells_;
+  alignas(CACHE_LINE_SIZE) std::atomic<size_t> enqueue_pos_;
+  alignas(CACHE_LINE_SIZE) std::atomic<size_t> dequeue_pos_;
+  char padding_[CACHE_LINE_SIZE - sizeof(std::atomic<size_t>)];
+};
+
+//
+// Bounded wait-free ring with one producer and one consumer. The consumer looks at the oldest value in place with
+// front() and releases its slot with pop().
+//
+
+template <typename T>
+class log_spsc_ring {
+public:
+  explicit log_spsc_ring(size_t capacity)
+      : mask_(log_ring_capacity(capacity) - 1), values_(new T[mask_ + 1]), head_(0), tail_cache_(0), tail_(0),
+        head_cache_(0) {
+  }
+
+  log_spsc_ring(const log_spsc_ring &) = delete;
+  log_spsc_ring &operator=(const log_spsc_ring &) = delete;
+
+  // Producer only
+  template <typename Fill>
+  bool try_push(Fill &fill) {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_cache_ > mask_) {
+      head_cache_ = head_.load(std::memory_order_acquire);
+      if (tail - head_cache_ > mask_) {
+        return false;
+      }
+    }
+    fill(values_[tail & mask_]);
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer only
+  T *front() {
+    size_t head = head_.load(std::memory_order_relaxed);
+    if (head == tail_cache_) {
+      tail_cache_ = tail_.load(std::memory_order_acquire);
+      if (head == tail_cache_) {
+        return nullptr;
+      }
+    }
+    return &values_[head & mask_];
+  }
+
+  // Consumer only
+  void pop() {
+    head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+
+private:
+  static const size_t CACHE_LINE_SIZE = 64;
+
+  const size_t mask_;
+  std::unique_ptr<T[]> values_;
+  alignas(CACHE_LINE_SIZE) std::atomic<size_t> head_;
+  size_t tail_cache_;
+  alignas(CACHE_LINE_SIZE) std::atomic<size_t> tail_;
+  size_t head_cache_;
+};
+
+//
+// Pushes a value to ring under an overflow policy once the ring is full: LOG_OVERFLOW_DROP_NEWEST gives up on it,
+// LOG_OVERFLOW_DROP_OLDEST drops droppable values from the front of the ring, and otherwise wait() is called until
+// the value fits. wait() returns false to give up. Values dropped either way are counted in dropped.
+//
+
+template <typename T, typename Fill, typename Release, typename Wait>
+bool log_ring_push(log_ring<T> &ring,
+                   Fill &fill,
+                   bool droppable,
+                   int overflow,
+                   Release release,
+                   Wait wait,
+                   std::atomic<unsigned long long> &dropped) {
+  while (!ring.try_push(fill, droppable)) {
+    if (overflow == LOG_OVERFLOW_DROP_NEWEST) {
+      dropped.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    if (overflow == LOG_OVERFLOW_DROP_OLDEST && ring.try_drop_oldest(release)) {
+      dropped.fetch_add(1, std::memory_order_relaxed);
+      continue;
+    }
+    if (!wait()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace log
+
+} // namespace xl
@@ -20,10 +20,20 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 
+#include "log_crash_ring.h"
+#include "log_ring.h"
+#include <algorithm>
+#include <chrono>
 #include <gtest/gtest.h>
+#include <limits>
+#include <memory>
+#include <vector>
 #include <xl/file>
 #include <xl/log>
 #include <xl/log_setup>
+#include <xl/process>
+#include <xl/thread>
+#include <yyjson.h>
 
 TEST(log_test, normal) {
   xl::fs::unlink(_T("test.log"));
@@ -35,13 +45,479 @@ TEST(log_test, normal) {
   XL_LOG_WARN("warn ", 1, " 2 ", 3, " log");
   XL_LOG_INFO("info ", 1, " 2 ", 3, " log");
   XL_LOG_DEBUG("debug ", 1, " 2 ", 3, " log");
+  int evaluated = 0;
+  XL_LOG_DEBUG("debug ", ++evaluated);
+  ASSERT_EQ(evaluated, 0);
+  XL_LOG_INFO("types ", -1, ' ', 2u, ' ', 1.5, ' ', true, ' ', std::string("s"), ' ', L"wide", ' ', std::wstring(L"w"));
+  XL_LOG_INFO("fields ", xl::log::field("status", 200), ' ', xl::log::field("path", "/"));
+  std::string long_message(1000, 'x');
+  XL_LOG_INFO("long ", long_message);
+  evaluated = 0;
+  for (int i = 0; i < 7; ++i) {
+    XL_LOG_EVERY_N(XL_LOG_LEVEL_INFO, 3, "every_n ", i, ' ', ++evaluated);
+  }
+  ASSERT_EQ(evaluated, 3);
+  for (int i = 0; i < 2; ++i) {
+    XL_LOG_EVERY_N(XL_LOG_LEVEL_INFO, 0, "every_0 ", i);
+    XL_LOG_EVERY_N(XL_LOG_LEVEL_INFO, 1, "every_1 ", i);
+  }
+  for (int i = 0; i < 7; ++i) {
+    XL_LOG_FIRST_N(XL_LOG_LEVEL_INFO, 2, "first_n ", i);
+  }
+  for (int i = 0; i < 7; ++i) {
+    XL_LOG_EVERY_MS(XL_LOG_LEVEL_INFO, 60000, "every_ms ", i);
+    XL_LOG_RATE_LIMITED(XL_LOG_LEVEL_INFO, 0.01, 2, "rate_limited ", i);
+  }
 
   xl::log::shutdown();
 
   ASSERT_EQ(xl::file::read(_T("test.log")), "[FATAL][test]fatal 1 2 3 log\n"
                                             "[ERROR][test]error 1 2 3 log\n"
                                             "[WARN][test]warn 1 2 3 log\n"
-                                            "[INFO][test]info 1 2 3 log\n");
+                                            "[INFO][test]info 1 2 3 log\n"
+                                            "[INFO][test]types -1 2 1.5 1 s wide w\n"
+                                            "[INFO][test]fields status=200 path=/\n"
+                                            "[INFO][test]long " +
+                                                long_message +
+                                                "\n"
+                                                "[INFO][test]every_n 0 1\n"
+                                                "[INFO][test]suppressed 2 similar messages\n"
+                                                "[INFO][test]every_n 3 2\n"
+                                                "[INFO][test]suppressed 2 similar messages\n"
+                                                "[INFO][test]every_n 6 3\n"
+                                                "[INFO][test]every_0 0\n"
+                                                "[INFO][test]every_1 0\n"
+                                                "[INFO][test]every_0 1\n"
+                                                "[INFO][test]every_1 1\n"
+                                                "[INFO][test]first_n 0\n"
+                                                "[INFO][test]first_n 1\n"
+                                                "[INFO][test]every_ms 0\n"
+                                                "[INFO][test]rate_limited 0\n"
+                                                "[INFO][test]rate_limited 1\n");
+  ASSERT_EQ(xl::log::dropped(), 0);
 
   ASSERT_EQ(xl::fs::unlink(_T("test.log")), true);
 }
+
+namespace {
+
+std::string encode_args(const std::string &text, int number) {
+  std::string args;
+  xl::log::log_encode_arg(args, text);
+  xl::log::log_encode_arg(args, number);
+  return args;
+}
+
+// Lines of the records in a ring file, without their times
+std::vector<std::string> read_crash_ring(const TCHAR *path, int &state) {
+  std::string ring = xl::file::read(path);
+  std::vector<std::string> lines;
+  const xl::log::log_crash_ring_header *header = xl::log::log_crash_ring_file_header(ring);
+  if (header == nullptr) {
+    state = -1;
+    return lines;
+  }
+  state = header->state;
+  for (const xl::log::log_crash_slot *slot : xl::log::log_crash_ring_file_records(ring)) {
+    std::string line = xl::log::format_log_crash_slot(*slot);
+    lines.push_back(line.substr(line.find(']') + 1));
+  }
+  return lines;
+}
+
+} // namespace
+
+TEST(log_test, crash_ring) {
+  const TCHAR *path = _T("log_test_crash_ring.bin");
+  const TCHAR *previous = _T("log_test_crash_ring.bin.prev");
+  xl::fs::unlink(path);
+  xl::fs::unlink(previous);
+
+  xl::log::log_crash_ring ring;
+  ASSERT_EQ(ring.open(path, 4), true);
+  for (int i = 0; i < 5; ++i) {
+    std::string args = encode_args("record ", i);
+    ring.write(1000, XL_LOG_LEVEL_INFO, "/src/crash.cc", 10 + i, 7, args.data(), args.size());
+  }
+  // The long string does not fit after the first one, and is left out whole
+  std::string args = encode_args("truncated ", 5);
+  xl::log::log_encode_arg(args, std::string(1000, 'x'));
+  ring.write(1000, XL_LOG_LEVEL_ERROR, "crash.cc", 20, 7, args.data(), args.size());
+  ring.crash(11);
+
+  int state = 0;
+  std::vector<std::string> lines = read_crash_ring(path, state);
+  ASSERT_EQ(state, xl::log::LOG_CRASH_RING_CRASHED);
+  ASSERT_EQ(lines, std::vector<std::string>({"[INFO][crash.cc:L12][T7]record 2", "[INFO][crash.cc:L13][T7]record 3",
+                                             "[INFO][crash.cc:L14][T7]record 4",
+                                             "[ERROR][crash.cc:L20][T7]truncated 5..."}));
+
+  // Reopening keeps the crashed ring
+  xl::log::log_crash_ring next_ring;
+  ASSERT_EQ(next_ring.open(path, 4), true);
+  ASSERT_EQ(read_crash_ring(previous, state), lines);
+  ASSERT_EQ(state, xl::log::LOG_CRASH_RING_CRASHED);
+  ASSERT_EQ(read_crash_ring(path, state).empty(), true);
+  ASSERT_EQ(state, xl::log::LOG_CRASH_RING_RUNNING);
+
+  // A ring that was shut down is replaced
+  next_ring.close();
+  xl::log::log_crash_ring last_ring;
+  ASSERT_EQ(last_ring.open(path, 4), true);
+  ASSERT_EQ(read_crash_ring(previous, state), lines);
+  last_ring.close();
+
+  ASSERT_EQ(xl::fs::unlink(path), true);
+  ASSERT_EQ(xl::fs::unlink(previous), true);
+}
+
+namespace {
+
+std::vector<int> pop_all(xl::log::log_ring<int> &ring) {
+  std::vector<int> values;
+  while (ring.try_pop([&values](int &value) {
+    values.push_back(value);
+  })) {
+  }
+  return values;
+}
+
+bool push(xl::log::log_ring<int> &ring,
+          int value,
+          bool droppable,
+          int overflow,
+          std::function<bool()> wait,
+          std::atomic<unsigned long long> &dropped) {
+  auto fill = [value](int &slot) {
+    slot = value;
+  };
+  return xl::log::log_ring_push(ring, fill, droppable, overflow, [](int &) {}, wait, dropped);
+}
+
+std::vector<std::string> read_lines(const TCHAR *path) {
+  std::vector<std::string> lines;
+  std::string text = xl::file::read(path);
+  for (size_t begin = 0, end = 0; begin < text.length(); begin = end + 1) {
+    end = text.find('\n', begin);
+    if (end == std::string::npos) {
+      end = text.length();
+    }
+    lines.push_back(text.substr(begin, end - begin));
+  }
+  return lines;
+}
+
+// Logs count records from each of threads threads at once
+void log_from_threads(int threads, int count) {
+  std::vector<std::unique_ptr<xl::thread>> running;
+  for (int t = 0; t < threads; ++t) {
+    running.emplace_back(new xl::thread([t, count]() {
+      for (int i = 0; i < count; ++i) {
+        XL_LOG_INFO(t, ' ', i);
+      }
+    }));
+  }
+  for (auto &thread : running) {
+    thread->join();
+  }
+}
+
+} // namespace
+
+TEST(log_test, ring_overflow) {
+  std::atomic<unsigned long long> dropped{0};
+  int waits = 0;
+  auto no_wait = [&waits]() {
+    ++waits;
+    return false;
+  };
+
+  xl::log::log_ring<int> ring(4);
+  ASSERT_EQ(ring.capacity(), 4);
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_EQ(push(ring, i, true, xl::log::LOG_OVERFLOW_DROP_NEWEST, no_wait, dropped), true);
+  }
+  ASSERT_EQ(push(ring, 4, true, xl::log::LOG_OVERFLOW_DROP_NEWEST, no_wait, dropped), false);
+  ASSERT_EQ(dropped, 1);
+  ASSERT_EQ(pop_all(ring), std::vector<int>({0, 1, 2, 3}));
+
+  // Dropping the oldest stops at a value that is not droppable, and waits for the consumer instead
+  dropped = 0;
+  push(ring, 0, true, xl::log::LOG_OVERFLOW_DROP_OLDEST, no_wait, dropped);
+  push(ring, 1, true, xl::log::LOG_OVERFLOW_DROP_OLDEST, no_wait, dropped);
+  push(ring, 2, false, xl::log::LOG_OVERFLOW_DROP_OLDEST, no_wait, dropped);
+  push(ring, 3, true, xl::log::LOG_OVERFLOW_DROP_OLDEST, no_wait, dropped);
+  ASSERT_EQ(push(ring, 4, true, xl::log::LOG_OVERFLOW_DROP_OLDEST, no_wait, dropped), true);
+  ASSERT_EQ(push(ring, 5, true, xl::log::LOG_OVERFLOW_DROP_OLDEST, no_wait, dropped), true);
+  ASSERT_EQ(dropped, 2);
+  ASSERT_EQ(waits, 0);
+  ASSERT_EQ(push(ring, 6, true, xl::log::LOG_OVERFLOW_DROP_OLDEST, no_wait, dropped), false);
+  ASSERT_EQ(dropped, 2);
+  ASSERT_EQ(waits, 1);
+  std::vector<int> consumed;
+  auto consume = [&ring, &consumed]() {
+    ring.try_pop([&consumed](int &value) {
+      consumed.push_back(value);
+    });
+    return true;
+  };
+  ASSERT_EQ(push(ring, 6, true, xl::log::LOG_OVERFLOW_DROP_OLDEST, consume, dropped), true);
+  ASSERT_EQ(consumed, std::vector<int>({2}));
+  ASSERT_EQ(pop_all(ring), std::vector<int>({3, 4, 5, 6}));
+
+  // Blocking waits until there is room, and never drops
+  dropped = 0;
+  for (int i = 0; i < 4; ++i) {
+    push(ring, i, true, xl::log::LOG_OVERFLOW_BLOCK, no_wait, dropped);
+  }
+  waits = 0;
+  auto consume_later = [&waits, &consume]() {
+    return ++waits < 3 || consume();
+  };
+  ASSERT_EQ(push(ring, 4, true, xl::log::LOG_OVERFLOW_BLOCK, consume_later, dropped), true);
+  ASSERT_EQ(waits, 3);
+  ASSERT_EQ(dropped, 0);
+  ASSERT_EQ(pop_all(ring), std::vector<int>({1, 2, 3, 4}));
+}
+
+// Every record logged is either written or counted as dropped
+TEST(log_test, overflow) {
+  const TCHAR *path = _T("log_test_overflow.log");
+  const int THREADS = 4;
+  const int COUNT = 20000;
+  int overflows[] = {xl::log::LOG_OVERFLOW_BLOCK, xl::log::LOG_OVERFLOW_DROP_NEWEST, xl::log::LOG_OVERFLOW_DROP_OLDEST};
+  for (int overflow : overflows) {
+    xl::fs::unlink(path);
+    unsigned long long dropped = xl::log::dropped();
+    ASSERT_EQ(xl::log::setup(_T("test"), XL_LOG_LEVEL_INFO, xl::log::LOG_CONTENT_LEVEL, xl::log::LOG_TARGET_FILE, path,
+                             overflow),
+              true);
+    log_from_threads(THREADS, COUNT);
+    xl::log::shutdown();
+    dropped = xl::log::dropped() - dropped;
+    if (overflow == xl::log::LOG_OVERFLOW_BLOCK) {
+      ASSERT_EQ(dropped, 0);
+    }
+    ASSERT_EQ(read_lines(path).size() + dropped, THREADS * COUNT);
+  }
+  ASSERT_EQ(xl::fs::unlink(path), true);
+}
+
+// shutdown() writes everything out whatever the durability, and an idle log thread writes within flush_interval
+TEST(log_test, durability) {
+  const TCHAR *path = _T("log_test_durability.log");
+  const unsigned int FLUSH_INTERVAL = 200;
+  int durabilities[] = {xl::log::LOG_DURABILITY_NONE, xl::log::LOG_DURABILITY_BATCH, xl::log::LOG_DURABILITY_SYNC};
+  for (int durability : durabilities) {
+    xl::fs::unlink(path);
+    ASSERT_EQ(xl::log::setup(_T("test"), XL_LOG_LEVEL_INFO, xl::log::LOG_CONTENT_LEVEL, xl::log::LOG_TARGET_FILE, path,
+                             xl::log::LOG_OVERFLOW_BLOCK, durability, xl::log::LOG_BUFFER_SIZE_DEFAULT, FLUSH_INTERVAL),
+              true);
+    auto logged_at = std::chrono::steady_clock::now();
+    XL_LOG_INFO("first");
+    if (durability == xl::log::LOG_DURABILITY_NONE) {
+      std::string text = xl::file::read(path);
+      // Nothing is due before flush_interval; skip the check if this thread was descheduled that long
+      if (std::chrono::steady_clock::now() - logged_at < std::chrono::milliseconds(FLUSH_INTERVAL / 2)) {
+        ASSERT_EQ(text, "");
+      }
+    }
+    xl::process::sleep(FLUSH_INTERVAL * 3);
+    ASSERT_EQ(xl::file::read(path), "[INFO]first\n");
+    for (int i = 0; i < 1000; ++i) {
+      XL_LOG_INFO("record ", i);
+    }
+    xl::log::shutdown();
+    std::vector<std::string> lines = read_lines(path);
+    ASSERT_EQ(lines.size(), 1001);
+    ASSERT_EQ(lines.back(), "[INFO]record 999");
+  }
+  ASSERT_EQ(xl::fs::unlink(path), true);
+}
+
+namespace {
+
+// Rotated segments next to the log file, oldest first
+std::vector<xl::native_string> list_segments(const TCHAR *dir) {
+  std::vector<xl::native_string> segments;
+  xl::fs::enum_dir(dir, [&segments](const xl::native_string &name, bool is_dir) {
+    if (!is_dir && name != _T("test.log")) {
+      segments.push_back(name);
+    }
+    return true;
+  });
+  std::sort(segments.begin(), segments.end());
+  return segments;
+}
+
+bool is_segment_name(const xl::native_string &name, const xl::native_string &extension) {
+  // test.log.YYYYmmdd-HHMMSS-mmm
+  const size_t PREFIX = 9;
+  const size_t LENGTH = PREFIX + 19;
+  if (name.length() != LENGTH + extension.length() || name.compare(0, PREFIX, _T("test.log.")) != 0 ||
+      name.compare(LENGTH, extension.length(), extension) != 0) {
+    return false;
+  }
+  for (size_t i = PREFIX; i < LENGTH; ++i) {
+    bool digit = name[i] >= _T('0') && name[i] <= _T('9');
+    if (digit != (i != PREFIX + 8 && i != PREFIX + 15)) {
+      return false;
+    }
+  }
+  return name[PREFIX + 8] == _T('-') && name[PREFIX + 15] == _T('-');
+}
+
+} // namespace
+
+TEST(log_test, rotation) {
+  const TCHAR *dir = _T("log_test_rotation");
+  xl::native_string path = xl::path::join(dir, _T("test.log"));
+  // Each record is 16 bytes and written on its own, so every file takes 4 records
+  const unsigned long long MAX_SIZE = 64;
+  const unsigned int MAX_FILES = 3;
+  bool compresses[] = {false, true};
+  for (bool compress : compresses) {
+    xl::fs::remove_all(dir);
+    ASSERT_EQ(xl::fs::mkdir(dir), true);
+    ASSERT_EQ(xl::log::setup(_T("test"), XL_LOG_LEVEL_INFO, xl::log::LOG_CONTENT_LEVEL, xl::log::LOG_TARGET_FILE,
+                             path.c_str(), xl::log::LOG_OVERFLOW_BLOCK, xl::log::LOG_DURABILITY_BATCH, 1),
+              true);
+    ASSERT_EQ(xl::log::setup_rotation(MAX_SIZE, MAX_FILES, xl::log::LOG_ROTATE_NONE, compress), true);
+    for (int i = 10; i < 42; ++i) {
+      XL_LOG_INFO("record ", i);
+    }
+    xl::log::shutdown();
+
+    // 8 files were written, and only the newest 3 rotated ones are kept
+    ASSERT_EQ(xl::file::read(path.c_str()), "[INFO]record 38\n[INFO]record 39\n[INFO]record 40\n[INFO]record 41\n");
+    std::vector<xl::native_string> segments = list_segments(dir);
+    ASSERT_EQ(segments.size(), MAX_FILES);
+    for (const auto &segment : segments) {
+      ASSERT_EQ(is_segment_name(segment, compress ? _T(".zip") : _T("")), true);
+    }
+    if (!compress) {
+      ASSERT_EQ(xl::file::read(xl::path::join(dir, segments[0]).c_str()),
+                "[INFO]record 26\n[INFO]record 27\n[INFO]record 28\n[INFO]record 29\n");
+      ASSERT_EQ(xl::file::read(xl::path::join(dir, segments[2]).c_str()),
+                "[INFO]record 34\n[INFO]record 35\n[INFO]record 36\n[INFO]record 37\n");
+    }
+  }
+  ASSERT_EQ(xl::fs::remove_all(dir), true);
+}
+
+TEST(log_test, json) {
+  const TCHAR *path = _T("log_test_json.log");
+  xl::fs::unlink(path);
+  xl::log::setup_format(xl::log::LOG_FORMAT_JSON);
+  ASSERT_EQ(xl::log::setup(_T("test"), XL_LOG_LEVEL_INFO,
+                           xl::log::LOG_CONTENT_LEVEL | xl::log::LOG_CONTENT_APP_NAME | xl::log::LOG_CONTENT_LINE,
+                           xl::log::LOG_TARGET_FILE, path),
+            true);
+  int line = __LINE__ + 1;
+  XL_LOG_WARN("request \"done\" ", xl::log::field("status", 200), ' ', xl::log::field("size", 7u), ' ',
+              xl::log::field("elapsed", 1.5), ' ', xl::log::field("cached", true), ' ', xl::log::field("path", "/a\n"),
+              " in ", 3, "ms");
+  // Fields named as built-in members must not repeat their keys
+  XL_LOG_INFO("reserved", xl::log::field("level", 1), xl::log::field("message", "m"), xl::log::field("app", "a"));
+  xl::log::shutdown();
+  xl::log::setup_format(xl::log::LOG_FORMAT_DEFAULT);
+
+  std::vector<std::string> lines = read_lines(path);
+  ASSERT_EQ(lines.size(), 2);
+
+  yyjson_doc *doc = yyjson_read(lines[0].data(), lines[0].length(), 0);
+  ASSERT_NE(doc, nullptr);
+  yyjson_val *root = yyjson_doc_get_root(doc);
+  ASSERT_EQ(yyjson_obj_size(root), 9);
+  ASSERT_EQ(std::string(yyjson_get_str(yyjson_obj_get(root, "level"))), "WARN");
+  ASSERT_EQ(std::string(yyjson_get_str(yyjson_obj_get(root, "app"))), "test");
+  ASSERT_EQ(yyjson_get_uint(yyjson_obj_get(root, "line")), (uint64_t)line);
+  ASSERT_EQ(std::string(yyjson_get_str(yyjson_obj_get(root, "message"))), "request \"done\"      in 3ms");
+  // Non-negative integers are read back as unsigned
+  ASSERT_EQ(yyjson_is_int(yyjson_obj_get(root, "status")), true);
+  ASSERT_EQ(yyjson_get_uint(yyjson_obj_get(root, "status")), 200);
+  ASSERT_EQ(yyjson_is_uint(yyjson_obj_get(root, "size")), true);
+  ASSERT_EQ(yyjson_get_uint(yyjson_obj_get(root, "size")), 7);
+  ASSERT_EQ(yyjson_is_real(yyjson_obj_get(root, "elapsed")), true);
+  ASSERT_EQ(yyjson_get_real(yyjson_obj_get(root, "elapsed")), 1.5);
+  ASSERT_EQ(yyjson_is_bool(yyjson_obj_get(root, "cached")), true);
+  ASSERT_EQ(yyjson_get_bool(yyjson_obj_get(root, "cached")), true);
+  ASSERT_EQ(std::string(yyjson_get_str(yyjson_obj_get(root, "path"))), "/a\n");
+  yyjson_doc_free(doc);
+
+  doc = yyjson_read(lines[1].data(), lines[1].length(), 0);
+  ASSERT_NE(doc, nullptr);
+  root = yyjson_doc_get_root(doc);
+  ASSERT_EQ(yyjson_obj_size(root), 7);
+  ASSERT_EQ(std::string(yyjson_get_str(yyjson_obj_get(root, "level"))), "INFO");
+  ASSERT_EQ(std::string(yyjson_get_str(yyjson_obj_get(root, "app"))), "test");
+  ASSERT_EQ(std::string(yyjson_get_str(yyjson_obj_get(root, "message"))), "reserved");
+  ASSERT_EQ(yyjson_get_uint(yyjson_obj_get(root, "fields.level")), 1);
+  ASSERT_EQ(std::string(yyjson_get_str(yyjson_obj_get(root, "fields.message"))), "m");
+  ASSERT_EQ(std::string(yyjson_get_str(yyjson_obj_get(root, "fields.app"))), "a");
+  yyjson_doc_free(doc);
+
+  ASSERT_EQ(xl::fs::unlink(path), true);
+}
+
+// Records logged through per-thread rings keep each thread's order, and none are left behind by shutdown()
+TEST(log_test, per_thread_queue) {
+  const TCHAR *path = _T("log_test_per_thread.log");
+  const int THREADS = 4;
+  const int COUNT = 5000;
+  xl::fs::unlink(path);
+  xl::log::setup_queue(xl::log::LOG_QUEUE_PER_THREAD);
+  ASSERT_EQ(xl::log::setup(_T("test"), XL_LOG_LEVEL_INFO, xl::log::LOG_CONTENT_LEVEL, xl::log::LOG_TARGET_FILE, path,
+                           xl::log::LOG_OVERFLOW_BLOCK),
+            true);
+  log_from_threads(THREADS, COUNT);
+  // Handled in time order with the records of the threads
+  XL_LOG_INFO("last");
+  xl::log::shutdown();
+  xl::log::setup_queue(xl::log::LOG_QUEUE_DEFAULT);
+
+  std::vector<std::string> lines = read_lines(path);
+  ASSERT_EQ(lines.size(), THREADS * COUNT + 1);
+  ASSERT_EQ(lines.back(), "[INFO]last");
+  std::vector<int> next(THREADS, 0);
+  for (size_t i = 0; i + 1 < lines.size(); ++i) {
+    int t = -1, n = -1;
+    ASSERT_EQ(sscanf(lines[i].c_str(), "[INFO]%d %d", &t, &n), 2);
+    ASSERT_EQ(t >= 0 && t < THREADS, true);
+    ASSERT_EQ(n, next[t]);
+    ++next[t];
+  }
+  ASSERT_EQ(xl::fs::unlink(path), true);
+}
+
+TEST(log_test, rate_limited) {
+  uint64_t suppressed = 0;
+  // Rates that never refill the bucket let only the first burst calls through
+  double rates[] = {0, -1, 1e-300, std::numeric_limits<double>::quiet_NaN()};
+  for (double rate : rates) {
+    xl::log::log_sampler sampler;
+    ASSERT_EQ(sampler.rate_limited(rate, 2, suppressed), true);
+    ASSERT_EQ(sampler.rate_limited(rate, 2, suppressed), true);
+    ASSERT_EQ(sampler.rate_limited(rate, 2, suppressed), false);
+    ASSERT_EQ(sampler.rate_limited(rate, 2, suppressed), false);
+  }
+
+  // A burst too large for its interval is bounded rather than overflowing
+  xl::log::log_sampler sampler;
+  for (int i = 0; i < 100; ++i) {
+    ASSERT_EQ(sampler.rate_limited(1e-6, UINT64_MAX, suppressed), true);
+  }
+
+  xl::log::log_sampler unlimited;
+  for (int i = 0; i < 100; ++i) {
+    ASSERT_EQ(unlimited.rate_limited(std::numeric_limits<double>::infinity(), 1, suppressed), true);
+  }
+
+  // Intervals too long to count in nanoseconds are bounded too
+  int64_t intervals[] = {INT64_MAX, INT64_MAX / 1000000 + 1, -1};
+  for (int64_t interval : intervals) {
+    xl::log::log_sampler every_ms;
+    ASSERT_EQ(every_ms.every_ms(interval, suppressed), true);
+    ASSERT_EQ(every_ms.every_ms(interval, suppressed), interval < 0);
+  }
+}
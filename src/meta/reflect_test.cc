@@ -21,6 +21,7 @@
 // SOFTWARE.
 
 #include <gtest/gtest.h>
+#include <unordered_set>
 #include <xl/reflect>
 
 namespace {
@@ -34,6 +35,12 @@ XL_REFLECT_END()
 
 #pragma pack(pop)
 
+XL_REFLECT_BEGIN(Prefixes)
+  XL_REFLECT_MEMBER(int, abc)
+  XL_REFLECT_MEMBER(int, ab)
+  XL_REFLECT_MEMBER(int, a)
+XL_REFLECT_END()
+
 } // namespace
 
 TEST(reflect_test, normal) {
@@ -85,3 +92,113 @@ TEST(reflect_test, normal) {
   ASSERT_EQ(*(int *)foo.field_data(0), 789);
   ASSERT_EQ(strcmp(*(const char **)foo.field_data(1), "ghi"), 0);
 }
+
+TEST(reflect_test, field_index) {
+  ASSERT_EQ(Prefixes::field_index("abc"), 0);
+  ASSERT_EQ(Prefixes::field_index("ab"), 1);
+  ASSERT_EQ(Prefixes::field_index("a"), 2);
+  ASSERT_EQ(Prefixes::field_index(""), -1);
+  ASSERT_EQ(Prefixes::field_index("abcd"), -1);
+  ASSERT_EQ(Prefixes::field_index("abcd", 3), 0);
+  ASSERT_EQ(Prefixes::field_index("abcd", 2), 1);
+  ASSERT_EQ(Prefixes::field_index("abcd", 1), 2);
+  ASSERT_EQ(Prefixes::field_index("b", 1), -1);
+}
+
+namespace {
+
+struct FieldNames {
+  template <typename Field>
+  void operator()(Field) {
+    names += Field::name();
+    names += Field::type() == typeid(int) ? ":int;" : ":?;";
+  }
+  std::string &names;
+};
+
+} // namespace
+
+TEST(reflect_test, descriptor) {
+  ASSERT_EQ(strcmp(Foo::descriptor(1).name, "b"), 0);
+  ASSERT_EQ(Foo::descriptor(1).offset(), sizeof(int));
+  ASSERT_EQ(Foo::descriptor(1).size, sizeof(const char *));
+  ASSERT_EQ(Foo::descriptor(1).type(), typeid(const char *));
+
+  ASSERT_EQ(Foo::field_type(2), typeid(nullptr));
+  ASSERT_EQ(Foo::field_name(2), nullptr);
+  ASSERT_EQ(Foo::field_offset(2), -1);
+  ASSERT_EQ(Foo::field_size(2), -1);
+  Foo foo;
+  ASSERT_EQ(foo.field_data(2), nullptr);
+
+  std::string names;
+  Prefixes::for_each_field(FieldNames{names});
+  ASSERT_EQ(names, "abc:int;ab:int;a:int;");
+}
+
+namespace {
+
+XL_REFLECT_BEGIN(Key)
+  XL_REFLECT_MEMBER(int, a)
+  XL_REFLECT_MEMBER(short, b)
+  XL_REFLECT_MEMBER(short, c)
+  XL_REFLECT_MEMBER(long long, d)
+  XL_REFLECT_MEMBER(std::string, name)
+  XL_REFLECT_MEMBER(double, weight)
+XL_REFLECT_END_COMPARABLE()
+
+// Padding between a and b, so that they are hashed one by one
+XL_REFLECT_BEGIN(Padded)
+  XL_REFLECT_MEMBER(char, a)
+  XL_REFLECT_MEMBER(int, b)
+  XL_REFLECT_MEMBER(std::vector<Key>, keys)
+XL_REFLECT_END_COMPARABLE()
+
+Key make_key(int a, short b, short c, long long d, const char *name, double weight) {
+  Key key;
+  key.a = a;
+  key.b = b;
+  key.c = c;
+  key.d = d;
+  key.name = name;
+  key.weight = weight;
+  return key;
+}
+
+} // namespace
+
+TEST(reflect_test, comparable) {
+  Key key = make_key(1, 2, 3, 4, "abc", 0.0);
+  ASSERT_EQ(key == make_key(1, 2, 3, 4, "abc", -0.0), true);
+  ASSERT_EQ(key.hash(), make_key(1, 2, 3, 4, "abc", -0.0).hash());
+  ASSERT_EQ(key != make_key(1, 2, 3, 5, "abc", 0.0), true);
+  ASSERT_NE(key.hash(), make_key(1, 2, 3, 5, "abc", 0.0).hash());
+  ASSERT_NE(key.hash(), make_key(1, 2, 4, 4, "abc", 0.0).hash());
+  ASSERT_NE(key.hash(), make_key(1, 2, 3, 4, "abd", 0.0).hash());
+  ASSERT_NE(key.hash(), make_key(1, 2, 3, 4, "abc", 1.0).hash());
+
+  ASSERT_EQ(key < make_key(1, 2, 3, 4, "abc", 0.0), false);
+  ASSERT_EQ(key < make_key(1, 2, 3, 4, "abd", -1.0), true);
+  ASSERT_EQ(key < make_key(0, 9, 9, 9, "zzz", 9.0), false);
+  ASSERT_EQ(key < make_key(1, 3, 0, 0, "", 0.0), true);
+
+  Padded padded1, padded2;
+  memset((void *)&padded1, 0x00, offsetof(Padded, keys));
+  memset((void *)&padded2, 0xff, offsetof(Padded, keys));
+  padded1.a = padded2.a = 'x';
+  padded1.b = padded2.b = 5;
+  padded1.keys.push_back(key);
+  padded2.keys.push_back(key);
+  ASSERT_EQ(padded1 == padded2, true);
+  ASSERT_EQ(padded1.hash(), padded2.hash());
+  padded2.keys[0].name = "abd";
+  ASSERT_EQ(padded1 == padded2, false);
+  ASSERT_NE(padded1.hash(), padded2.hash());
+
+  std::unordered_set<Key, xl::reflect_hash> keys;
+  keys.insert(key);
+  keys.insert(make_key(1, 2, 3, 4, "abc", -0.0));
+  keys.insert(make_key(1, 2, 3, 4, "", 0.0));
+  ASSERT_EQ(keys.size(), 2);
+  ASSERT_EQ(keys.count(make_key(1, 2, 3, 4, "", 0.0)), 1);
+}
@@ -0,0 +1,127 @@
+// MIT License
+//
+// Copyright (c) 2022 Streamlet (streamlet@outlook.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <gtest/gtest.h>
+#include <string>
+#include <xl/soa_vector>
+
+namespace {
+
+XL_REFLECT_BEGIN(Row)
+  XL_REFLECT_MEMBER(int, id)
+  XL_REFLECT_MEMBER(double, price)
+  XL_REFLECT_MEMBER(bool, active)
+  XL_REFLECT_MEMBER(std::string, name)
+XL_REFLECT_END()
+
+Row make_row(int id, double price, bool active, const char *name) {
+  Row row;
+  row.id = id;
+  row.price = price;
+  row.active = active;
+  row.name = name;
+  return row;
+}
+
+} // namespace
+
+TEST(soa_vector_test, normal) {
+  xl::soa_vector<Row> rows;
+  ASSERT_EQ(rows.empty(), true);
+  rows.push_back(make_row(1, 2.5, true, "a"));
+  rows.push_back(make_row(2, 1.5, false, "b"));
+  rows.push_back(make_row(3, 3.5, true, "c"));
+  ASSERT_EQ(rows.size(), 3);
+
+  Row row = rows.get(1);
+  ASSERT_EQ(row.id, 2);
+  ASSERT_EQ(row.price, 1.5);
+  ASSERT_EQ(row.active, false);
+  ASSERT_EQ(row.name, "b");
+
+  ASSERT_EQ(rows[2].get<0>(), 3);
+  ASSERT_EQ(rows[2].get<3>(), "c");
+  rows[2].get<1>() = 4.5;
+  rows[0] = make_row(10, 0.5, false, "x");
+  row = rows[0];
+  ASSERT_EQ(row.id, 10);
+  ASSERT_EQ(row.name, "x");
+
+  xl::soa_span<double> prices = rows.column<1>();
+  ASSERT_EQ(prices.size(), 3);
+  ASSERT_EQ(prices[0], 0.5);
+  ASSERT_EQ(prices[1], 1.5);
+  ASSERT_EQ(prices[2], 4.5);
+  double sum = 0;
+  for (double price : prices) {
+    sum += price;
+  }
+  ASSERT_EQ(sum, 6.5);
+
+  const xl::soa_vector<Row> &view = rows;
+  xl::soa_span<const bool> active = view.column<2>();
+  ASSERT_EQ(active[0], false);
+  ASSERT_EQ(active[1], false);
+  ASSERT_EQ(active[2], true);
+
+  int ids = 0;
+  for (auto it : view) {
+    ids += it.get<0>();
+  }
+  ASSERT_EQ(ids, 15);
+
+  rows[1] = rows[0];
+  row = rows[1];
+  ASSERT_EQ(row.id, 10);
+  ASSERT_EQ(row.name, "x");
+  rows[2] = view[1];
+  ASSERT_EQ(rows[2].get<0>(), 10);
+  ASSERT_EQ(rows[2].get<3>(), "x");
+  ASSERT_EQ(rows[0].get<0>(), 10);
+
+  rows.pop_back();
+  ASSERT_EQ(rows.size(), 2);
+  rows.clear();
+  ASSERT_EQ(rows.empty(), true);
+}
+
+TEST(soa_vector_test, sort) {
+  xl::soa_vector<Row> rows;
+  rows.push_back(make_row(1, 2.5, true, "a"));
+  rows.push_back(make_row(2, 1.5, false, "b"));
+  rows.push_back(make_row(3, 3.5, true, "c"));
+
+  rows.sort_by<1>();
+  ASSERT_EQ(rows[0].get<0>(), 2);
+  ASSERT_EQ(rows[1].get<0>(), 1);
+  ASSERT_EQ(rows[2].get<0>(), 3);
+  ASSERT_EQ(rows[0].get<3>(), "b");
+  ASSERT_EQ(rows[0].get<2>(), false);
+
+  rows.sort([](xl::soa_vector<Row>::const_reference lhs, xl::soa_vector<Row>::const_reference rhs) {
+    return lhs.get<3>() > rhs.get<3>();
+  });
+  ASSERT_EQ(rows[0].get<0>(), 3);
+  ASSERT_EQ(rows[1].get<0>(), 2);
+  ASSERT_EQ(rows[2].get<0>(), 1);
+  ASSERT_EQ(rows.column<1>()[0], 3.5);
+}
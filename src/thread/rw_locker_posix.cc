@@ -0,0 +1,82 @@
+// MIT License
+//
+// Copyright (c) 2022 Streamlet (streamlet@outlook.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <cassert>
+#include <pthread.h>
+#include <xl/synchronous>
+
+namespace xl {
+
+rw_locker::rw_locker() {
+  pthread_rwlock_t *rwlock = new pthread_rwlock_t;
+  pthread_rwlockattr_t attr = {};
+  int r = pthread_rwlockattr_init(&attr);
+  assert(r == 0);
+#ifdef __GLIBC__
+  // glibc prefers readers by default, darwin prefers writers already
+  r = pthread_rwlockattr_setkind_np(&attr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+  assert(r == 0);
+#endif
+  r = pthread_rwlock_init(rwlock, &attr);
+  assert(r == 0);
+  r = pthread_rwlockattr_destroy(&attr);
+  assert(r == 0);
+  platform_context_ = rwlock;
+}
+
+rw_locker::~rw_locker() {
+  pthread_rwlock_t *rwlock = (pthread_rwlock_t *)platform_context_;
+  int r = pthread_rwlock_destroy(rwlock);
+  assert(r == 0);
+  delete rwlock;
+  platform_context_ = nullptr;
+}
+
+bool rw_locker::try_lock_shared() {
+  return pthread_rwlock_tryrdlock((pthread_rwlock_t *)platform_context_) == 0;
+}
+
+void rw_locker::lock_shared() {
+  int r = pthread_rwlock_rdlock((pthread_rwlock_t *)platform_context_);
+  assert(r == 0);
+}
+
+void rw_locker::unlock_shared() {
+  int r = pthread_rwlock_unlock((pthread_rwlock_t *)platform_context_);
+  assert(r == 0);
+}
+
+bool rw_locker::try_lock() {
+  return pthread_rwlock_trywrlock((pthread_rwlock_t *)platform_context_) == 0;
+}
+
+void rw_locker::lock() {
+  int r = pthread_rwlock_wrlock((pthread_rwlock_t *)platform_context_);
+  assert(r == 0);
+}
+
+void rw_locker::unlock() {
+  int r = pthread_rwlock_unlock((pthread_rwlock_t *)platform_context_);
+  assert(r == 0);
+}
+
+} // namespace xl
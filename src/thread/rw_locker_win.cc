@@ -0,0 +1,128 @@
+// MIT License
+//
+// Copyright (c) 2022 Streamlet (streamlet@outlook.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <cassert>
+#include <xl/synchronous>
+
+//
+// SRWLOCK is not available on Windows XP, and does not prefer writers, so here it is built on locker and events.
+//
+
+namespace xl {
+
+namespace {
+
+typedef struct rw_locker_context {
+  rw_locker_context() : readers_ok(true, false), writer_ok(false, true) {
+  }
+
+  locker state_locker;
+  event readers_ok; // manual reset, signaled while no writer is active or waiting
+  event writer_ok;  // auto reset, signaled when a waiting writer may proceed
+  int readers = 0;
+  int waiting_writers = 0;
+  bool writer = false;
+} rw_locker_context;
+
+} // namespace
+
+rw_locker::rw_locker() {
+  platform_context_ = new rw_locker_context;
+}
+
+rw_locker::~rw_locker() {
+  rw_locker_context *context = (rw_locker_context *)platform_context_;
+  assert(context->readers == 0 && !context->writer);
+  delete context;
+  platform_context_ = nullptr;
+}
+
+bool rw_locker::try_lock_shared() {
+  rw_locker_context *context = (rw_locker_context *)platform_context_;
+  lock_guard lock(context->state_locker);
+  if (context->writer || context->waiting_writers > 0) {
+    return false;
+  }
+  ++context->readers;
+  return true;
+}
+
+void rw_locker::lock_shared() {
+  rw_locker_context *context = (rw_locker_context *)platform_context_;
+  while (!try_lock_shared()) {
+    context->readers_ok.wait();
+  }
+}
+
+void rw_locker::unlock_shared() {
+  rw_locker_context *context = (rw_locker_context *)platform_context_;
+  lock_guard lock(context->state_locker);
+  assert(context->readers > 0);
+  if (--context->readers == 0 && context->waiting_writers > 0) {
+    context->writer_ok.set();
+  }
+}
+
+bool rw_locker::try_lock() {
+  rw_locker_context *context = (rw_locker_context *)platform_context_;
+  lock_guard lock(context->state_locker);
+  if (context->writer || context->readers > 0) {
+    return false;
+  }
+  context->writer = true;
+  context->readers_ok.reset();
+  return true;
+}
+
+void rw_locker::lock() {
+  rw_locker_context *context = (rw_locker_context *)platform_context_;
+  {
+    lock_guard lock(context->state_locker);
+    ++context->waiting_writers;
+    context->readers_ok.reset();
+  }
+  while (true) {
+    {
+      lock_guard lock(context->state_locker);
+      if (!context->writer && context->readers == 0) {
+        --context->waiting_writers;
+        context->writer = true;
+        return;
+      }
+    }
+    context->writer_ok.wait();
+  }
+}
+
+void rw_locker::unlock() {
+  rw_locker_context *context = (rw_locker_context *)platform_context_;
+  lock_guard lock(context->state_locker);
+  assert(context->writer);
+  context->writer = false;
+  if (context->waiting_writers > 0) {
+    context->writer_ok.set();
+  } else {
+    context->readers_ok.set();
+  }
+}
+
+} // namespace xl
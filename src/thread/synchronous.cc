@@ -25,6 +25,8 @@
 
 namespace xl {
 
+#ifndef __linux__
+
 locker::locker() : event_(true, true) {
 }
 
@@ -43,12 +45,30 @@ void locker::unlock() {
   event_.set();
 }
 
-lock_guard::lock_guard(locker &locker) : locker_(locker) {
-  locker_.lock();
+#endif
+
+lock_guard::lock_guard(locker &locker) : locker_(&locker) {
+  locker_->lock();
+}
+
+lock_guard::lock_guard(rw_locker &locker) : rw_locker_(&locker) {
+  rw_locker_->lock();
 }
 
 lock_guard ::~lock_guard() {
-  locker_.unlock();
+  if (locker_ != nullptr) {
+    locker_->unlock();
+  } else {
+    rw_locker_->unlock();
+  }
+}
+
+shared_lock_guard::shared_lock_guard(rw_locker &locker) : locker_(locker) {
+  locker_.lock_shared();
+}
+
+shared_lock_guard::~shared_lock_guard() {
+  locker_.unlock_shared();
 }
 
 } // namespace xl
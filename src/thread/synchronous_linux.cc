@@ -0,0 +1,193 @@
+// MIT License
+//
+// Copyright (c) 2022 Streamlet (streamlet@outlook.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <cassert>
+#include <climits>
+#include <errno.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#include <xl/synchronous>
+
+//
+// Linux implementation on bare futex words, see "Futexes Are Tricky" (Ulrich Drepper) for the locker algorithm.
+//
+
+namespace xl {
+
+namespace {
+
+static_assert(sizeof(std::atomic<int>) == sizeof(int), "futex word must be a plain int");
+
+int futex_wait(std::atomic<int> *word, int expected, const struct timespec *timeout) {
+  return (int)::syscall(SYS_futex, (int *)word, FUTEX_WAIT_PRIVATE, expected, timeout, nullptr, 0);
+}
+
+void futex_wake(std::atomic<int> *word, int count) {
+  ::syscall(SYS_futex, (int *)word, FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0);
+}
+
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+  asm volatile("yield" ::: "memory");
+#endif
+}
+
+long long monotonic_ms() {
+  struct timespec ts = {};
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+enum EventState {
+  EVENT_RESET = 0,
+  EVENT_SIGNALED = 1,
+  EVENT_RESET_WITH_WAITERS = 2,
+};
+
+typedef struct event_context {
+  std::atomic<int> state;
+  bool auto_reset = true;
+} event_context;
+
+// Returns false on timeout. A null deadline means infinite.
+bool event_wait(event_context *context, const long long *deadline) {
+  bool waited = false;
+  while (true) {
+    int state = context->state.load(std::memory_order_acquire);
+    if (state == EVENT_SIGNALED) {
+      if (!context->auto_reset) {
+        return true;
+      }
+      // a waiter that has slept may not be the only one, so keep the others marked
+      if (context->state.compare_exchange_weak(state, waited ? EVENT_RESET_WITH_WAITERS : EVENT_RESET,
+                                               std::memory_order_acquire)) {
+        return true;
+      }
+      continue;
+    }
+    if (state == EVENT_RESET &&
+        !context->state.compare_exchange_weak(state, EVENT_RESET_WITH_WAITERS, std::memory_order_relaxed)) {
+      continue;
+    }
+    struct timespec timeout = {};
+    if (deadline != nullptr) {
+      long long left = *deadline - monotonic_ms();
+      if (left <= 0) {
+        return false;
+      }
+      timeout.tv_sec = left / 1000;
+      timeout.tv_nsec = (left % 1000) * 1000000;
+    }
+    int r = futex_wait(&context->state, EVENT_RESET_WITH_WAITERS, deadline == nullptr ? nullptr : &timeout);
+    assert(r == 0 || errno == EAGAIN || errno == EINTR || errno == ETIMEDOUT);
+    (void)r;
+    waited = true;
+  }
+}
+
+const int LOCKER_SPIN_COUNT = 100;
+
+} // namespace
+
+event::event(bool init_signaled, bool auto_reset) {
+  event_context *context = new event_context;
+  context->state.store(init_signaled ? EVENT_SIGNALED : EVENT_RESET, std::memory_order_relaxed);
+  context->auto_reset = auto_reset;
+  platform_context_ = context;
+}
+
+event::~event() {
+  event_context *context = (event_context *)platform_context_;
+  delete context;
+  platform_context_ = nullptr;
+}
+
+void event::wait() const {
+  event_context *context = (event_context *)platform_context_;
+  event_wait(context, nullptr);
+}
+
+bool event::timed_wait(unsigned long milliseconds) const {
+  event_context *context = (event_context *)platform_context_;
+  assert(milliseconds != (unsigned long)-1);
+  long long deadline = monotonic_ms() + milliseconds;
+  return event_wait(context, &deadline);
+}
+
+void event::set() const {
+  event_context *context = (event_context *)platform_context_;
+  if (context->state.exchange(EVENT_SIGNALED, std::memory_order_release) == EVENT_RESET_WITH_WAITERS) {
+    futex_wake(&context->state, context->auto_reset ? 1 : INT_MAX);
+  }
+}
+
+void event::reset() const {
+  event_context *context = (event_context *)platform_context_;
+  int state = EVENT_SIGNALED;
+  context->state.compare_exchange_strong(state, EVENT_RESET, std::memory_order_relaxed);
+}
+
+locker::locker() : state_(0) {
+}
+
+locker::~locker() {
+}
+
+bool locker::try_lock() {
+  int state = 0;
+  return state_.compare_exchange_strong(state, 1, std::memory_order_acquire);
+}
+
+void locker::lock() {
+  int state = 0;
+  if (state_.compare_exchange_strong(state, 1, std::memory_order_acquire)) {
+    return;
+  }
+  for (int i = 0; i < LOCKER_SPIN_COUNT && state != 2; ++i) {
+    cpu_relax();
+    state = 0;
+    if (state_.load(std::memory_order_relaxed) == 0 &&
+        state_.compare_exchange_weak(state, 1, std::memory_order_acquire)) {
+      return;
+    }
+  }
+  if (state != 2) {
+    state = state_.exchange(2, std::memory_order_acquire);
+  }
+  while (state != 0) {
+    futex_wait(&state_, 2, nullptr);
+    state = state_.exchange(2, std::memory_order_acquire);
+  }
+}
+
+void locker::unlock() {
+  if (state_.fetch_sub(1, std::memory_order_release) != 1) {
+    state_.store(0, std::memory_order_release);
+    futex_wake(&state_, 1);
+  }
+}
+
+} // namespace xl
@@ -0,0 +1,170 @@
+// MIT License
+//
+// Copyright (c) 2022 Streamlet (streamlet@outlook.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <atomic>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <memory>
+#include <vector>
+#include <xl/synchronous>
+#include <xl/thread>
+
+TEST(synchronous_test, locker) {
+  xl::locker locker;
+  ASSERT_EQ(locker.try_lock(), true);
+  ASSERT_EQ(locker.try_lock(), false);
+  locker.unlock();
+
+  const int THREADS = 8;
+  const int LOOPS = 10000;
+  long long counter = 0;
+  std::vector<std::unique_ptr<xl::thread>> threads;
+  for (int i = 0; i < THREADS; ++i) {
+    threads.emplace_back(new xl::thread([&]() {
+      for (int j = 0; j < LOOPS; ++j) {
+        xl::lock_guard lock(locker);
+        ++counter;
+      }
+    }));
+  }
+  for (auto &t : threads) {
+    t->join();
+  }
+  ASSERT_EQ(counter, THREADS * LOOPS);
+}
+
+TEST(synchronous_test, event_auto_reset) {
+  xl::event e(false, true);
+  ASSERT_EQ(e.timed_wait(0), false);
+  e.set();
+  ASSERT_EQ(e.timed_wait(0), true);
+  ASSERT_EQ(e.timed_wait(0), false);
+
+  auto begin = std::chrono::steady_clock::now();
+  ASSERT_EQ(e.timed_wait(50), false);
+  ASSERT_GE(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - begin).count(),
+            45);
+
+  std::atomic<int> woken(0);
+  std::vector<std::unique_ptr<xl::thread>> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back(new xl::thread([&]() {
+      e.wait();
+      ++woken;
+    }));
+  }
+  for (int i = 0; i < 4; ++i) {
+    e.set();
+    while (woken.load() < i + 1) {
+    }
+  }
+  for (auto &t : threads) {
+    t->join();
+  }
+  ASSERT_EQ(woken.load(), 4);
+}
+
+TEST(synchronous_test, event_manual_reset) {
+  xl::event e(true, false);
+  ASSERT_EQ(e.timed_wait(0), true);
+  ASSERT_EQ(e.timed_wait(0), true);
+  e.reset();
+  ASSERT_EQ(e.timed_wait(0), false);
+
+  std::atomic<int> woken(0);
+  std::vector<std::unique_ptr<xl::thread>> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back(new xl::thread([&]() {
+      e.wait();
+      ++woken;
+    }));
+  }
+  e.set();
+  for (auto &t : threads) {
+    t->join();
+  }
+  ASSERT_EQ(woken.load(), 4);
+}
+
+TEST(synchronous_test, rw_locker) {
+  xl::rw_locker locker;
+  ASSERT_EQ(locker.try_lock_shared(), true);
+  ASSERT_EQ(locker.try_lock_shared(), true);
+  ASSERT_EQ(locker.try_lock(), false);
+  locker.unlock_shared();
+  locker.unlock_shared();
+  ASSERT_EQ(locker.try_lock(), true);
+  ASSERT_EQ(locker.try_lock_shared(), false);
+  ASSERT_EQ(locker.try_lock(), false);
+  locker.unlock();
+
+  const int THREADS = 8;
+  const int LOOPS = 10000;
+  long long counter = 0;
+  std::atomic<int> readers(0);
+  std::atomic<bool> overlapped(false);
+  std::vector<std::unique_ptr<xl::thread>> threads;
+  for (int i = 0; i < THREADS; ++i) {
+    threads.emplace_back(new xl::thread([&, i]() {
+      for (int j = 0; j < LOOPS; ++j) {
+        if (j % 10 == i % 10) {
+          xl::lock_guard lock(locker);
+          if (readers.load() != 0) {
+            overlapped = true;
+          }
+          ++counter;
+        } else {
+          xl::shared_lock_guard lock(locker);
+          ++readers;
+          --readers;
+        }
+      }
+    }));
+  }
+  for (auto &t : threads) {
+    t->join();
+  }
+  ASSERT_EQ(overlapped.load(), false);
+  ASSERT_EQ(counter, THREADS * LOOPS / 10);
+}
+
+TEST(synchronous_test, rw_locker_writer_preference) {
+  xl::rw_locker locker;
+  locker.lock_shared();
+  std::atomic<bool> writer_waiting(false), writer_done(false);
+  xl::thread writer([&]() {
+    writer_waiting = true;
+    xl::lock_guard lock(locker);
+    writer_done = true;
+  });
+  while (!writer_waiting.load()) {
+  }
+  // give the writer time to block in lock()
+  xl::event(false, true).timed_wait(50);
+  ASSERT_EQ(locker.try_lock_shared(), false);
+  ASSERT_EQ(writer_done.load(), false);
+  locker.unlock_shared();
+  writer.join();
+  ASSERT_EQ(writer_done.load(), true);
+  ASSERT_EQ(locker.try_lock_shared(), true);
+  locker.unlock_shared();
+}
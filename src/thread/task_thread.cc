@@ -24,7 +24,8 @@
 
 namespace xl {
 
-task_thread::task_thread() : thread_(std::bind(&task_thread::run, this)) {
+task_thread::task_thread(unsigned int spin_count)
+    : has_tasks_(false), spin_count_(spin_count), wake_(false, true), thread_(std::bind(&task_thread::run, this)) {
 }
 
 task_thread::~task_thread() {
@@ -33,17 +34,32 @@ task_thread::~task_thread() {
 }
 
 bool task_thread::post_task(std::function<void()> &&task) {
-  lock_guard lock(locker_);
-  if (quit_) {
-    return false;
+  bool wake = false;
+  {
+    lock_guard lock(locker_);
+    if (quit_) {
+      return false;
+    }
+    tasks_.push(std::move(task));
+    has_tasks_.store(true, std::memory_order_relaxed);
+    std::swap(wake, sleeping_);
+  }
+  if (wake) {
+    wake_.set();
   }
-  tasks_.push(std::move(task));
   return true;
 }
 
 void task_thread::quit() {
-  lock_guard lock(locker_);
-  quit_ = true;
+  bool wake = false;
+  {
+    lock_guard lock(locker_);
+    quit_ = true;
+    std::swap(wake, sleeping_);
+  }
+  if (wake) {
+    wake_.set();
+  }
 }
 
 void task_thread::join() {
@@ -60,6 +76,14 @@ void task_thread::run() {
       lock_guard lock(locker_);
       run = !quit_;
       std::swap(tasks, tasks_);
+      has_tasks_.store(false, std::memory_order_relaxed);
+      sleeping_ = run && tasks.empty();
+    }
+    if (tasks.empty()) {
+      if (run) {
+        wait_for_tasks();
+      }
+      continue;
     }
     while (!tasks.empty()) {
       tasks.front()();
@@ -68,4 +92,13 @@ void task_thread::run() {
   }
 }
 
-} // namespace xl
\ No newline at end of file
+void task_thread::wait_for_tasks() {
+  for (unsigned int i = 0; i < spin_count_; ++i) {
+    if (has_tasks_.load(std::memory_order_relaxed)) {
+      return;
+    }
+  }
+  wake_.wait();
+}
+
+} // namespace xl
@@ -20,9 +20,17 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 
+#include <algorithm>
+#include <chrono>
 #include <gtest/gtest.h>
+#include <vector>
 #include <xl/process>
 #include <xl/task_thread>
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <time.h>
+#endif
 
 TEST(task_thread_test, normal) {
   int tid = xl::process::tid();
@@ -43,3 +51,60 @@ TEST(task_thread_test, normal) {
   tt.quit();
   tt.join();
 }
+
+namespace {
+
+long long process_cpu_time_ms() {
+#ifdef _WIN32
+  FILETIME creation_time = {}, exit_time = {}, kernel_time = {}, user_time = {};
+  ::GetProcessTimes(::GetCurrentProcess(), &creation_time, &exit_time, &kernel_time, &user_time);
+  ULARGE_INTEGER kernel = {kernel_time.dwLowDateTime, kernel_time.dwHighDateTime};
+  ULARGE_INTEGER user = {user_time.dwLowDateTime, user_time.dwHighDateTime};
+  return (long long)((kernel.QuadPart + user.QuadPart) / 10000);
+#else
+  timespec ts = {};
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+  return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+#endif
+}
+
+std::vector<long long> post_to_execute_latencies(xl::task_thread &tt, int count) {
+  std::vector<long long> latencies;
+  xl::event done(false, true);
+  for (int i = 0; i < count; ++i) {
+    auto posted = std::chrono::steady_clock::now();
+    tt.post_task([&, posted]() {
+      auto executed = std::chrono::steady_clock::now();
+      latencies.push_back(std::chrono::duration_cast<std::chrono::microseconds>(executed - posted).count());
+      done.set();
+    });
+    done.wait();
+  }
+  std::sort(latencies.begin(), latencies.end());
+  return latencies;
+}
+
+} // namespace
+
+TEST(task_thread_test, idle) {
+  xl::task_thread tt;
+  xl::task_thread tt_spin(1000);
+  xl::process::sleep(100);
+  long long begin = process_cpu_time_ms();
+  xl::process::sleep(500);
+  long long cpu_time = process_cpu_time_ms() - begin;
+  ASSERT_LT(cpu_time, 50);
+}
+
+TEST(task_thread_test, latency) {
+  const int COUNT = 1000;
+  xl::task_thread tt;
+  std::vector<long long> latencies = post_to_execute_latencies(tt, COUNT);
+  ASSERT_EQ(latencies.size(), COUNT);
+  ASSERT_LT(latencies[COUNT / 2], 10000);
+
+  xl::task_thread tt_spin(100000);
+  std::vector<long long> spin_latencies = post_to_execute_latencies(tt_spin, COUNT);
+  ASSERT_EQ(spin_latencies.size(), COUNT);
+  ASSERT_LT(spin_latencies[COUNT / 2], 10000);
+}
@@ -0,0 +1,311 @@
+// MIT License
+//
+// Copyright (c) 2022 Streamlet (streamlet@outlook.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <cassert>
+#include <queue>
+#include <xl/thread_pool>
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace xl {
+
+namespace {
+
+typedef std::function<void()> task;
+
+//
+// Chase-Lev work-stealing deque, following "Correct and Efficient Work-Stealing for Weak Memory Models"
+// (Le, Pop, Cohen, Zappa Nardelli, PPoPP 2013). The owner pushes and takes at the bottom, thieves steal at the top.
+// Replaced arrays are kept until the deque is destroyed, as a thief may still be reading them.
+//
+
+class work_stealing_deque {
+public:
+  work_stealing_deque() : top_(0), bottom_(0), array_(nullptr) {
+    arrays_.emplace_back(new circular_array(INITIAL_LOG_SIZE));
+    array_.store(arrays_.back().get(), std::memory_order_relaxed);
+  }
+
+  void push(task *t) {
+    long long b = bottom_.load(std::memory_order_relaxed);
+    long long top = top_.load(std::memory_order_acquire);
+    circular_array *a = array_.load(std::memory_order_relaxed);
+    if (b - top > a->size() - 1) {
+      a = grow(a, top, b);
+    }
+    a->put(b, t);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom_.store(b + 1, std::memory_order_relaxed);
+  }
+
+  task *take() {
+    long long b = bottom_.load(std::memory_order_relaxed) - 1;
+    circular_array *a = array_.load(std::memory_order_relaxed);
+    bottom_.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    long long top = top_.load(std::memory_order_relaxed);
+    if (top > b) {
+      bottom_.store(b + 1, std::memory_order_relaxed);
+      return nullptr;
+    }
+    task *t = a->get(b);
+    if (top == b) {
+      if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+        t = nullptr;
+      }
+      bottom_.store(b + 1, std::memory_order_relaxed);
+    }
+    return t;
+  }
+
+  task *steal() {
+    long long top = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    long long b = bottom_.load(std::memory_order_acquire);
+    if (top >= b) {
+      return nullptr;
+    }
+    circular_array *a = array_.load(std::memory_order_acquire);
+    task *t = a->get(top);
+    if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+      return nullptr;
+    }
+    return t;
+  }
+
+private:
+  static const int INITIAL_LOG_SIZE = 8;
+
+  class circular_array {
+  public:
+    explicit circular_array(int log_size) : log_size_(log_size), items_(new std::atomic<task *>[1LL << log_size]) {
+    }
+
+    long long size() const {
+      return 1LL << log_size_;
+    }
+
+    task *get(long long i) const {
+      return items_[i & (size() - 1)].load(std::memory_order_relaxed);
+    }
+
+    void put(long long i, task *t) {
+      items_[i & (size() - 1)].store(t, std::memory_order_relaxed);
+    }
+
+    circular_array *grow(long long top, long long bottom) const {
+      circular_array *a = new circular_array(log_size_ + 1);
+      for (long long i = top; i < bottom; ++i) {
+        a->put(i, get(i));
+      }
+      return a;
+    }
+
+  private:
+    int log_size_;
+    std::unique_ptr<std::atomic<task *>[]> items_;
+  };
+
+  circular_array *grow(circular_array *a, long long top, long long bottom) {
+    arrays_.emplace_back(a->grow(top, bottom));
+    circular_array *new_array = arrays_.back().get();
+    array_.store(new_array, std::memory_order_release);
+    return new_array;
+  }
+
+  std::atomic<long long> top_;
+  std::atomic<long long> bottom_;
+  std::atomic<circular_array *> array_;
+  std::vector<std::unique_ptr<circular_array>> arrays_;
+};
+
+size_t processor_count() {
+#ifdef _WIN32
+  SYSTEM_INFO si = {};
+  ::GetSystemInfo(&si);
+  return si.dwNumberOfProcessors;
+#else
+  long count = ::sysconf(_SC_NPROCESSORS_ONLN);
+  return count > 0 ? (size_t)count : 1;
+#endif
+}
+
+const unsigned long IDLE_WAIT_MILLISECONDS = 50;
+const unsigned long HELP_WAIT_MILLISECONDS = 1;
+
+} // namespace
+
+struct thread_pool::context {
+  struct worker {
+    work_stealing_deque deque;
+    unsigned int random = 0;
+    std::unique_ptr<thread> worker_thread;
+  };
+
+  context() : wake(false, true) {
+  }
+
+  std::vector<std::unique_ptr<worker>> workers;
+  std::queue<task *> shared_tasks;
+  locker shared_locker;
+  std::atomic<size_t> pending{0};
+  std::atomic<size_t> sleeping{0};
+  std::atomic<bool> quit{false};
+  event wake;
+};
+
+namespace {
+
+struct current_worker_t {
+  const void *pool;
+  size_t index;
+};
+
+thread_local current_worker_t current_worker_ = {nullptr, 0};
+
+} // namespace
+
+thread_pool::thread_pool(size_t thread_count) : context_(new context) {
+  if (thread_count == 0) {
+    thread_count = processor_count();
+  }
+  for (size_t i = 0; i < thread_count; ++i) {
+    context_->workers.emplace_back(new context::worker);
+    context_->workers.back()->random = (unsigned int)(i * 2654435761u + 1);
+  }
+  for (size_t i = 0; i < thread_count; ++i) {
+    context_->workers[i]->worker_thread.reset(new thread([this, i]() {
+      current_worker_.pool = this;
+      current_worker_.index = i;
+      context &c = *context_;
+      while (true) {
+        if (run_pending_task()) {
+          continue;
+        }
+        if (c.quit.load() && c.pending.load() == 0) {
+          // pass the wake-up on to the next worker to quit
+          c.wake.set();
+          break;
+        }
+        c.sleeping.fetch_add(1);
+        if (c.pending.load() == 0 && !c.quit.load()) {
+          c.wake.timed_wait(IDLE_WAIT_MILLISECONDS);
+        }
+        c.sleeping.fetch_sub(1);
+      }
+    }));
+  }
+}
+
+thread_pool::~thread_pool() {
+  context_->quit.store(true);
+  context_->wake.set();
+  for (auto &w : context_->workers) {
+    w->worker_thread->join();
+  }
+}
+
+size_t thread_pool::size() const {
+  return context_->workers.size();
+}
+
+void thread_pool::post(std::function<void()> &&function) {
+  context &c = *context_;
+  task *t = new task(std::move(function));
+  c.pending.fetch_add(1);
+  if (in_worker()) {
+    c.workers[current_worker_.index]->deque.push(t);
+  } else {
+    lock_guard lock(c.shared_locker);
+    c.shared_tasks.push(t);
+  }
+  if (c.sleeping.load() > 0) {
+    c.wake.set();
+  }
+}
+
+bool thread_pool::run_pending_task() {
+  context &c = *context_;
+  if (c.pending.load() == 0) {
+    return false;
+  }
+
+  task *t = nullptr;
+  size_t self = c.workers.size();
+  unsigned int random = 0;
+  if (in_worker()) {
+    self = current_worker_.index;
+    t = c.workers[self]->deque.take();
+    random = c.workers[self]->random;
+  }
+  if (t == nullptr) {
+    lock_guard lock(c.shared_locker);
+    if (!c.shared_tasks.empty()) {
+      t = c.shared_tasks.front();
+      c.shared_tasks.pop();
+    }
+  }
+  if (t == nullptr) {
+    // xorshift, to spread thieves over victims
+    random ^= random << 13;
+    random ^= random >> 17;
+    random ^= random << 5;
+    if (self < c.workers.size()) {
+      c.workers[self]->random = random;
+    }
+    size_t count = c.workers.size();
+    for (size_t i = 0; i < count && t == nullptr; ++i) {
+      size_t victim = (random + i) % count;
+      if (victim != self) {
+        t = c.workers[victim]->deque.steal();
+      }
+    }
+  }
+  if (t == nullptr) {
+    return false;
+  }
+
+  // more work is pending, pass the wake-up on to another sleeping worker
+  if (c.pending.fetch_sub(1) > 1 && c.sleeping.load() > 0) {
+    c.wake.set();
+  }
+  (*t)();
+  delete t;
+  return true;
+}
+
+bool thread_pool::in_worker() const {
+  return current_worker_.pool == this;
+}
+
+void thread_pool::wait_until(const std::function<bool()> &done, const event &signal) {
+  while (!done()) {
+    if (!run_pending_task()) {
+      signal.timed_wait(HELP_WAIT_MILLISECONDS);
+    }
+  }
+}
+
+} // namespace xl
@@ -0,0 +1,130 @@
+// MIT License
+//
+// Copyright (c) 2022 Streamlet (streamlet@outlook.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <atomic>
+#include <gtest/gtest.h>
+#include <vector>
+#include <xl/process>
+#include <xl/thread_pool>
+
+TEST(thread_pool_test, post) {
+  xl::thread_pool pool(4);
+  ASSERT_EQ(pool.size(), 4);
+  std::atomic<int> count(0);
+  for (int i = 0; i < 1000; ++i) {
+    pool.post([&]() {
+      ++count;
+    });
+  }
+  while (count.load() < 1000) {
+    xl::process::sleep(1);
+  }
+  ASSERT_EQ(count.load(), 1000);
+}
+
+TEST(thread_pool_test, submit) {
+  xl::thread_pool pool(2);
+  int tid = xl::process::tid();
+  xl::task_handle<long> handle = pool.submit([]() {
+    return xl::process::tid();
+  });
+  ASSERT_NE(handle.get(), tid);
+  ASSERT_EQ(handle.ready(), true);
+
+  bool executed = false;
+  xl::task_handle<void> void_handle = pool.submit([&]() {
+    executed = true;
+  });
+  void_handle.wait();
+  ASSERT_EQ(executed, true);
+}
+
+TEST(thread_pool_test, nested_submit) {
+  xl::thread_pool pool(2);
+  xl::task_handle<int> outer = pool.submit([&]() {
+    std::vector<xl::task_handle<int>> inner;
+    for (int i = 0; i < 100; ++i) {
+      inner.push_back(pool.submit([i]() {
+        return i;
+      }));
+    }
+    int sum = 0;
+    for (auto &handle : inner) {
+      sum += handle.get();
+    }
+    return sum;
+  });
+  ASSERT_EQ(outer.get(), 4950);
+}
+
+TEST(thread_pool_test, parallel_for) {
+  xl::thread_pool pool(4);
+  std::vector<int> values(10000, 0);
+  pool.parallel_for<size_t>(0, values.size(), [&](size_t i) {
+    values[i] = (int)i * 2;
+  });
+  for (size_t i = 0; i < values.size(); ++i) {
+    ASSERT_EQ(values[i], (int)i * 2);
+  }
+
+  std::atomic<int> count(0);
+  pool.parallel_for(0, 10, [&](int) {
+    pool.parallel_for(0, 10, [&](int) {
+      ++count;
+    });
+  });
+  ASSERT_EQ(count.load(), 100);
+}
+
+TEST(thread_pool_test, parallel_reduce) {
+  xl::thread_pool pool(4);
+  long long sum = pool.parallel_reduce(
+      1, 100001, 0LL,
+      [](int i) {
+        return (long long)i;
+      },
+      [](long long a, long long b) {
+        return a + b;
+      },
+      100);
+  ASSERT_EQ(sum, 5000050000LL);
+
+  std::string s = pool.parallel_reduce(
+      0, 26, std::string(),
+      [](int i) {
+        return std::string(1, (char)('a' + i));
+      },
+      [](const std::string &a, const std::string &b) {
+        return a + b;
+      });
+  ASSERT_EQ(s, "abcdefghijklmnopqrstuvwxyz");
+
+  bool all_even = pool.parallel_reduce(
+      0, 1000, true,
+      [](int i) {
+        return i * 2 % 2 == 0;
+      },
+      [](bool a, bool b) {
+        return a && b;
+      });
+  ASSERT_EQ(all_even, true);
+}
@@ -51,8 +51,10 @@ void thread::join() {
 }
 
 void thread::detach() {
-  pthread_detach(handle_);
-  handle_ = 0;
+  if (handle_ != 0) {
+    pthread_detach(handle_);
+    handle_ = 0;
+  }
 }
 
 void *thread::run(void *context) {
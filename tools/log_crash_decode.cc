@@ -0,0 +1,67 @@
+// MIT License
+//
+// Copyright (c) 2022 Streamlet (streamlet@outlook.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "../src/log/log_crash_ring.h"
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <xl/file>
+#include <xl/native_string>
+
+//
+// Prints the records kept in a crash ring written by xl::log::setup_crash_ring, oldest first.
+//
+// Usage: log_crash_decode <ring_file>
+//
+
+int _tmain(int argc, const TCHAR *argv[]) {
+  if (argc < 2) {
+    _tprintf(_T("Usage: %s <ring_file>\n"), argv[0]);
+    return 1;
+  }
+
+  std::string ring = xl::file::read(argv[1]);
+  const xl::log::log_crash_ring_header *header = xl::log::log_crash_ring_file_header(ring);
+  if (header == nullptr) {
+    _tprintf(_T("%s is not a crash ring, or was written by another version.\n"), argv[1]);
+    return 1;
+  }
+
+  switch (header->state) {
+  case xl::log::LOG_CRASH_RING_CRASHED:
+    printf("Process %lld crashed with signal %d.\n", (long long)header->pid, header->signal);
+    break;
+  case xl::log::LOG_CRASH_RING_CLOSED:
+    printf("Process %lld shut down its log.\n", (long long)header->pid);
+    break;
+  default:
+    printf("Process %lld is running, or was killed without a chance to mark the ring.\n", (long long)header->pid);
+    break;
+  }
+
+  std::vector<const xl::log::log_crash_slot *> records = xl::log::log_crash_ring_file_records(ring);
+  for (const auto *slot : records) {
+    printf("%s\n", xl::log::format_log_crash_slot(*slot).c_str());
+  }
+  printf("%u records.\n", (unsigned int)records.size());
+  return 0;
+}